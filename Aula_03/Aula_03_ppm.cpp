@@ -4,9 +4,36 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>  // For performance timing
+#include <charconv> // std::to_chars
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
+const int WIDTH = 1000;
+const int HEIGHT = 1000;
+
+// Body rows [first, last) as text, one "r g b" line per pixel. std::to_chars
+// writes the digits without the locale work of <<, and the text goes into a
+// buffer instead of flushing the file (std::endl) after every pixel.
+void format_rows(int first, int last, std::string& text) {
+	const int INT_DIGITS = 11; // "-2147483648"
+	char line[3 * (INT_DIGITS + 1)];
+	for (int y = first; y < last; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			//Pixel RGB (0->> 255) 8 bits
+			char* end = std::to_chars(line, line + INT_DIGITS, y).ptr;
+			*end++ = ' ';
+			end = std::to_chars(end, end + INT_DIGITS, 255).ptr;
+			*end++ = ' ';
+			end = std::to_chars(end, end + INT_DIGITS, x).ptr;
+			*end++ = '\n';
+			text.append(line, end);
+		}
+	}
+}
+
 int main() {
 
 	std::cout << "----------------------------------------------------------------------" << std::endl;
@@ -20,35 +47,53 @@ int main() {
 	std::cout << std::endl;
 
 	std::ofstream image;
-	image.open("Image_5.ppm");
+	image.open("Image_5.ppm", std::ios::binary);
 	// Image PPM  Header
 	image << "P3" << std::endl;
-	image << "1000 1000" << std::endl;
+	image << WIDTH << " " << HEIGHT << std::endl;
 	image << "255" << std::endl;
 
 	//Timer
 	std::cout <<"Time Start!!"<< std::endl;
-	auto start_single_thread = std::chrono::high_resolution_clock::now();
-	// Image PPM Body
-	for (int y = 0;y < 1000;y++) {
-		for (int x = 0;x < 1000;x++) {
-			//Pixel RGB (0->> 255) 8 bits
-			
-			image << y << " " << 255 << " " << x << std::endl;
-			
-		}
-	 }
-	auto stop_single_thread = std::chrono::high_resolution_clock::now();
+	auto start_time = std::chrono::high_resolution_clock::now();
+	// Image PPM Body: every thread formats its own block of rows into its
+	// own buffer, then the blocks are joined in order and written at once
+	int num_threads = std::thread::hardware_concurrency();
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	std::vector<std::string> blocks(num_threads);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; t++) {
+		int first = HEIGHT * t / num_threads;
+		int last = HEIGHT * (t + 1) / num_threads;
+		threads.emplace_back(format_rows, first, last, std::ref(blocks[t]));
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	std::size_t size = 0;
+	for (const std::string& block : blocks) {
+		size += block.size();
+	}
+	std::string body;
+	body.reserve(size);
+	for (const std::string& block : blocks) {
+		body += block;
+	}
+	image.write(body.data(), body.size());
+	image.close();
+	auto stop_time = std::chrono::high_resolution_clock::now();
 	std::cout << "Time End!!" << std::endl;
 
-	auto duration_single_thread = std::chrono::duration_cast<std::chrono::milliseconds>(stop_single_thread - start_single_thread);
-	auto duration_single_thread = std::chrono::duration_cast<std::chrono::nanoseconds>(stop_single_thread - start_single_thread);
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop_time - start_time);
 
 
 	// Display timing results
-	cout << "Single-threaded image processing time: " << duration_single_thread.count() << " millis" << endl;
+	cout << "Image body written with " << num_threads << " threads in: " << duration.count() << " millis" << endl;
+
 
-	
-	return 0;image.close();
+	return 0;
 
 }
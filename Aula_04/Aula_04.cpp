@@ -57,11 +57,10 @@ int main() {
 
 	// Read each pixel!!
 
-		while (!old_image.eof()) {
+		// Stop as soon as a pixel can not be read (testing eof() before reading
+		// processes the last pixel twice)
+		while (old_image >> red >> green >> blue) {
 
-			old_image >> red;
-			old_image >> green;
-			old_image >> blue;
 			/*
 			Syntax:
 
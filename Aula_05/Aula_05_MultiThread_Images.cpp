@@ -2,6 +2,9 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "./stb_image/stb_image.h"
 #include "./stb_image/stb_image_write.h"
+#include "image.h"
+#include "ppm_io.h"
+#include "mapped_ppm.h"
 
 #include <iostream>
 #include <fstream>
@@ -13,127 +16,141 @@
 
 
 
-struct Pixel {
-    unsigned char r, g, b;
-};
 
 const std::string jpg_input_file = "apple.jpg";
 const std::string ppm_input_file = "apollo.ppm";
+const std::string ppm_p6_input_file = "imageP6.ppm";
 const std::string output_file_ppm = "output_ppm.ppm";
 const std::string output_file_stb = "output_stb.jpg";
+const std::string output_file_ppm_mapped = "output_ppm_mapped.ppm";
+const std::string output_file_ppm_ascii = "output_ppm_ascii.ppm";
 
 // Function to apply a filter (e.g., grayscale) on a region of the image
-void apply_filter(std::vector<std::vector<Pixel>>& image, int start_row, int end_row) {
+void apply_filter(Image& image, int start_row, int end_row) {
     for (int i = start_row; i < end_row; ++i) {
-        for (int j = 0; j < image[i].size(); ++j) {
-            unsigned char gray = (image[i][j].r + image[i][j].g + image[i][j].b) / 3;
-            image[i][j].r = gray;
-            image[i][j].g = gray;
-            image[i][j].b = gray;
+        Pixel* row = image.row(i);
+        for (int j = 0; j < image.width(); ++j) {
+            unsigned char gray = (row[j].r + row[j].g + row[j].b) / 3;
+            row[j].r = gray;
+            row[j].g = gray;
+            row[j].b = gray;
+        }
+    }
+}
+
+// Same filter, reading from a read-only view and writing a new image
+void apply_filter_to(const ImageView& source, Image& output, int start_row, int end_row) {
+    for (int i = start_row; i < end_row; ++i) {
+        const Pixel* in = source.row(i);
+        Pixel* out = output.row(i);
+        for (int j = 0; j < source.width(); ++j) {
+            unsigned char gray = (in[j].r + in[j].g + in[j].b) / 3;
+            out[j].r = gray;
+            out[j].g = gray;
+            out[j].b = gray;
         }
     }
 }
 
 // Function to read PPM image
 void process_ppm_image(const std::string& input_file, const std::string& output_file) {
-    std::ifstream image_file(input_file, std::ios::binary);
-    if (!image_file.is_open()) {
-        std::cerr << "Error: Unable to open input PPM file." << std::endl;
+    Image image;
+    PpmHeader header;
+    IoStats read_stats;
+    if (!read_ppm(input_file, image, &header, &read_stats)) {
         return;
     }
+    print_io_stats("PPM read", read_stats);
+
+    // Apply the grayscale filter
+    apply_filter(image, 0, image.height());
 
-    std::string header;
-    int width, height, max_color_value;
+    // Write the processed image back to the output file
+    IoStats write_stats;
+    if (write_ppm(output_file, image, header.max_value, &write_stats)) {
+        print_io_stats("PPM write", write_stats);
+    }
+}
 
-    // Reading the PPM file header
-    image_file >> header;
-    if (header != "P3") {
-        std::cerr << "Error: Unsupported PPM format!" << std::endl;
+// Memory-mapped P6 image: the filter reads the pixels straight from the
+// mapping (page cache), so the input is never copied into our own buffer
+void process_ppm_image_mapped(const std::string& input_file, const std::string& output_file) {
+    MappedPpm input;
+    if (!input.open(input_file)) {
         return;
     }
-    image_file >> width >> height >> max_color_value;
-    image_file.ignore();  // Skip single whitespace character after the header
+    ImageView source = input.view();
 
-    std::vector<std::vector<Pixel>> image(height, std::vector<Pixel>(width));
+    Image image(source.width(), source.height());
+    apply_filter_to(source, image, 0, source.height());
 
-    // Reading pixel data
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            image_file.read(reinterpret_cast<char*>(&image[i][j]), sizeof(Pixel));
-        }
+    IoStats write_stats;
+    if (write_ppm(output_file, image, input.header().max_value, &write_stats)) {
+        print_io_stats("PPM write", write_stats);
     }
+}
 
-    image_file.close();
-
-    // Apply the grayscale filter
-    apply_filter(image, 0, height);
+// Convert an image to the ASCII (P3) format after filtering it
+void process_ppm_image_ascii(const std::string& input_file, const std::string& output_file) {
+    Image image;
+    PpmHeader header;
+    if (!read_ppm(input_file, image, &header)) {
+        return;
+    }
+    apply_filter(image, 0, image.height());
 
-    // Write the processed image back to the output file
-    std::ofstream output_image(output_file, std::ios::binary);
-    output_image << "P6\n" << width << " " << height << "\n" << max_color_value << "\n";
-    for (const auto& row : image) {
-        for (const auto& pixel : row) {
-            output_image.write(reinterpret_cast<const char*>(&pixel), sizeof(Pixel));
-        }
+    IoStats write_stats;
+    if (write_ppm_ascii(output_file, image, header.max_value, &write_stats)) {
+        print_io_stats("PPM write (P3)", write_stats);
     }
-    output_image.close();
 }
 
-// Using STB Image for other formats like JPG
-void process_stb_image(const std::string& input_file, const std::string& output_file) {
+// Load any STB-supported format straight into an Image.
+// The decoder's buffer is adopted as-is (no per-pixel copy) and released
+// with stbi_image_free when the Image goes away.
+bool load_stb_image(const std::string& input_file, Image& image) {
     int width, height, channels;
-    //unsigned char* data = stbi_load(filename, &x, &y, &n, 0);
-    unsigned char* data = stbi_load(jpg_input_file.c_str(), &width, &height, &channels, 0);
+    // Ask STB for 3 channels so the buffer is already laid out as packed Pixels
+    unsigned char* data = stbi_load(input_file.c_str(), &width, &height, &channels, STBI_rgb);
     if (!data) {
         std::cerr << "Error loading image: " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    image = Image::adopt(data, width, height, 0, stbi_image_free);
+    return true;
+}
+
+// Write the Image buffer directly as JPG (rows must be packed)
+void write_stb_jpg(const std::string& output_file, const Image& image) {
+    if (!image.is_packed()) {
+        std::cerr << "Error: stbi_write_jpg needs packed rows." << std::endl;
         return;
     }
+    stbi_write_jpg(output_file.c_str(), image.width(), image.height(), STBI_rgb, image.data(), 100);
+}
 
-    // Convert to vector of pixels
-    std::vector<std::vector<Pixel>> image(height, std::vector<Pixel>(width));
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int idx = (i * width + j) * channels;
-            image[i][j] = { data[idx], data[idx + 1], data[idx + 2] };
-        }
+// Using STB Image for other formats like JPG
+void process_stb_image(const std::string& input_file, const std::string& output_file) {
+    Image image;
+    if (!load_stb_image(input_file, image)) {
+        return;
     }
 
     // Apply the filter
-    apply_filter(image, 0, height);
-
-    // Convert back to unsigned char* for STB
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int idx = (i * width + j) * channels;
-            data[idx] = image[i][j].r;
-            data[idx + 1] = image[i][j].g;
-            data[idx + 2] = image[i][j].b;
-        }
-    }
+    apply_filter(image, 0, image.height());
 
     // Write the processed image
-    stbi_write_jpg(output_file.c_str(), width, height, channels, data, 100);
-
-    stbi_image_free(data);
+    write_stb_jpg(output_file, image);
 }
 
 // Multithreaded version
 void process_stb_image_multithreaded(const std::string& input_file, const std::string& output_file, int num_threads) {
-    int width, height, channels;
-    unsigned char* data = stbi_load(input_file.c_str(), &width, &height, &channels, 0);
-    if (!data) {
-        std::cerr << "Error loading image: " << stbi_failure_reason() << std::endl;
+    Image image;
+    if (!load_stb_image(input_file, image)) {
         return;
     }
-
-    // Convert to vector of pixels
-    std::vector<std::vector<Pixel>> image(height, std::vector<Pixel>(width));
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int idx = (i * width + j) * channels;
-            image[i][j] = { data[idx], data[idx + 1], data[idx + 2] };
-        }
-    }
+    int height = image.height();
 
     // Divide the image into regions and create threads
     int rows_per_region = height / num_threads;
@@ -150,20 +167,8 @@ void process_stb_image_multithreaded(const std::string& input_file, const std::s
         thread.join();
     }
 
-    // Convert back to unsigned char* for STB
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int idx = (i * width + j) * channels;
-            data[idx] = image[i][j].r;
-            data[idx + 1] = image[i][j].g;
-            data[idx + 2] = image[i][j].b;
-        }
-    }
-
     // Write the processed image
-    stbi_write_jpg(output_file.c_str(), width, height, channels, data, 100);
-
-    stbi_image_free(data);
+    write_stb_jpg(output_file, image);
 }
 
 int main() {
@@ -176,6 +181,20 @@ int main() {
     std::chrono::duration<double> duration_ppm = end_time - start_time;
     std::cout << "PPM time: " << duration_ppm.count() << " seconds\n";
 
+    // Measure time for memory-mapped PPM
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_mapped(ppm_p6_input_file, output_file_ppm_mapped);
+    end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration_ppm_mapped = end_time - start_time;
+    std::cout << "PPM (memory-mapped) time: " << duration_ppm_mapped.count() << " seconds\n";
+
+    // Measure time for exporting the same image as ASCII (P3)
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_ascii(ppm_p6_input_file, output_file_ppm_ascii);
+    end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration_ppm_ascii = end_time - start_time;
+    std::cout << "PPM (ASCII export) time: " << duration_ppm_ascii.count() << " seconds\n";
+
     // Measure time for STB Image (single-threaded)
     start_time = std::chrono::high_resolution_clock::now();
     process_stb_image(jpg_input_file, output_file_stb);
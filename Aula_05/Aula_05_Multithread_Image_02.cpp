@@ -8,98 +8,53 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "./stb_image/stb_image.h"
 #include "./stb_image/stb_image_write.h"
+#include "image.h"
+#include "ppm_io.h"
 
-struct Pixel {
-    unsigned char r, g, b;
-};
 
 // Function to apply a filter (e.g., grayscale) on a region of the image
-void apply_filter(std::vector<std::vector<Pixel>>& image, int start_row, int end_row) {
+void apply_filter(Image& image, int start_row, int end_row) {
     for (int i = start_row; i < end_row; ++i) {
-        for (int j = 0; j < image[i].size(); ++j) {
-            unsigned char gray = (image[i][j].r + image[i][j].g + image[i][j].b) / 3;
-            image[i][j].r = gray;
-            image[i][j].g = gray;
-            image[i][j].b = gray;
+        Pixel* row = image.row(i);
+        for (int j = 0; j < image.width(); ++j) {
+            unsigned char gray = (row[j].r + row[j].g + row[j].b) / 3;
+            row[j].r = gray;
+            row[j].g = gray;
+            row[j].b = gray;
         }
     }
 }
 
 // Function to read PPM image (single-threaded)
 void process_ppm_image(const std::string& input_file, const std::string& output_file) {
-    std::ifstream image_file(input_file, std::ios::binary);
-    if (!image_file.is_open()) {
-        std::cerr << "Error: Unable to open input PPM file." << std::endl;
+    Image image;
+    PpmHeader header;
+    IoStats read_stats;
+    if (!read_ppm(input_file, image, &header, &read_stats)) {
         return;
     }
-
-    std::string header;
-    int width, height, max_color_value;
-
-    // Reading the PPM file header
-    image_file >> header;
-    if (header != "P6") {
-        std::cerr << "Error: Unsupported PPM format!" << std::endl;
-        return;
-    }
-    image_file >> width >> height >> max_color_value;
-    image_file.ignore();  // Skip single whitespace character after the header
-
-    std::vector<std::vector<Pixel>> image(height, std::vector<Pixel>(width));
-
-    // Reading pixel data
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            image_file.read(reinterpret_cast<char*>(&image[i][j]), sizeof(Pixel));
-        }
-    }
-
-    image_file.close();
+    print_io_stats("PPM read", read_stats);
 
     // Apply the grayscale filter (single-threaded)
-    apply_filter(image, 0, height);
+    apply_filter(image, 0, image.height());
 
     // Write the processed image back to the output file
-    std::ofstream output_image(output_file, std::ios::binary);
-    output_image << "P6\n" << width << " " << height << "\n" << max_color_value << "\n";
-    for (const auto& row : image) {
-        for (const auto& pixel : row) {
-            output_image.write(reinterpret_cast<const char*>(&pixel), sizeof(Pixel));
-        }
+    IoStats write_stats;
+    if (write_ppm(output_file, image, header.max_value, &write_stats)) {
+        print_io_stats("PPM write", write_stats);
     }
-    output_image.close();
 }
 
 // Multithreaded PPM image processing
 void process_ppm_image_multithreaded(const std::string& input_file, const std::string& output_file, int num_threads) {
-    std::ifstream image_file(input_file, std::ios::binary);
-    if (!image_file.is_open()) {
-        std::cerr << "Error: Unable to open input PPM file." << std::endl;
+    Image image;
+    PpmHeader header;
+    IoStats read_stats;
+    if (!read_ppm(input_file, image, &header, &read_stats)) {
         return;
     }
-
-    std::string header;
-    int width, height, max_color_value;
-
-    // Reading the PPM file header
-    image_file >> header;
-    if (header != "P6") {
-        std::cerr << "Error: Unsupported PPM format!" << std::endl;
-        return;
-    }
-    image_file >> width >> height >> max_color_value;
-    image_file.ignore();  // Skip single whitespace character after the header
-
-    std::vector<std::vector<Pixel>> image(height, std::vector<Pixel>(width));
-
-    // Reading pixel data
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            image_file.read(reinterpret_cast<char*>(&image[i][j]), sizeof(Pixel));
-        }
-    }
-
-    image_file.close();
+    print_io_stats("PPM read", read_stats);
+    int height = image.height();
 
     // Divide the image into regions and create threads
     int rows_per_region = height / num_threads;
@@ -117,14 +72,10 @@ void process_ppm_image_multithreaded(const std::string& input_file, const std::s
     }
 
     // Write the processed image back to the output file
-    std::ofstream output_image(output_file, std::ios::binary);
-    output_image << "P6\n" << width << " " << height << "\n" << max_color_value << "\n";
-    for (const auto& row : image) {
-        for (const auto& pixel : row) {
-            output_image.write(reinterpret_cast<const char*>(&pixel), sizeof(Pixel));
-        }
+    IoStats write_stats;
+    if (write_ppm(output_file, image, header.max_value, &write_stats)) {
+        print_io_stats("PPM write", write_stats);
     }
-    output_image.close();
 }
 
 int main() {
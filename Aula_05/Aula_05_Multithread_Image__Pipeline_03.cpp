@@ -12,211 +12,147 @@ Filters:
  8. Edge Detection: Detects edges in the image.
  9. Sepia Tone: Applies a sepia tone effect.
  10 .Saturation Adjust: Adjusts the color saturation of the image
+ 11. Median: Removes noise with a median over a square window.
+ 12. Morphology: Erode, dilate, open and close with a rectangular element.
+ 13. Histogram Equalization / CLAHE: Spreads the levels globally or per tile.
+ 14. Otsu Thresholding: Picks the threshold(s) from the gray level histogram.
+ 15. Resize: Box, bilinear, bicubic or Lanczos resampling to any size.
+ 16. Geometry: Rotation by quarter turns, transpose and flips.
 
 */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <chrono>
+#include <iomanip>
 #include <thread>
-#include <functional>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "./stb_image/stb_image.h"
 #include "./stb_image/stb_image_write.h"
-
-struct Pixel {
-    unsigned char r, g, b;
-};
-
-// Filter function type for flexibility in the pipeline
-typedef std::function<void(std::vector<std::vector<Pixel>>&)> FilterFunction;
-
-// Grayscale Filter
-void grayscale_filter(std::vector<std::vector<Pixel>>& image) {
-    for (auto& row : image) {
-        for (auto& pixel : row) {
-            unsigned char gray = (pixel.r + pixel.g + pixel.b) / 3;
-            pixel.r = gray;
-            pixel.g = gray;
-            pixel.b = gray;
-        }
-    }
-}
-
-// Invert Filter
-void invert_filter(std::vector<std::vector<Pixel>>& image) {
-    for (auto& row : image) {
-        for (auto& pixel : row) {
-            pixel.r = 255 - pixel.r;
-            pixel.g = 255 - pixel.g;
-            pixel.b = 255 - pixel.b;
-        }
-    }
-}
-
-// Brightness Adjust Filter (scales brightness by a factor)
-void brightness_filter(std::vector<std::vector<Pixel>>& image, int factor) {
-    for (auto& row : image) {
-        for (auto& pixel : row) {
-            pixel.r = std::min(255, pixel.r + factor);
-            pixel.g = std::min(255, pixel.g + factor);
-            pixel.b = std::min(255, pixel.b + factor);
-        }
-    }
-}
-
-// Contrast Adjust Filter (simple contrast stretch)
-void contrast_filter(std::vector<std::vector<Pixel>>& image, float factor) {
-    for (auto& row : image) {
-        for (auto& pixel : row) {
-            pixel.r = std::clamp(int(((pixel.r - 128) * factor) + 128), 0, 255);
-            pixel.g = std::clamp(int(((pixel.g - 128) * factor) + 128), 0, 255);
-            pixel.b = std::clamp(int(((pixel.b - 128) * factor) + 128), 0, 255);
-        }
-    }
-}
-
-// Threshold Filter
-void threshold_filter(std::vector<std::vector<Pixel>>& image, unsigned char threshold) {
-    for (auto& row : image) {
-        for (auto& pixel : row) {
-            unsigned char gray = (pixel.r + pixel.g + pixel.b) / 3;
-            if (gray > threshold) {
-                pixel.r = pixel.g = pixel.b = 255;
-            }
-            else {
-                pixel.r = pixel.g = pixel.b = 0;
-            }
-        }
-    }
-}
-
-// Blur Filter (simple average blur)
-void blur_filter(std::vector<std::vector<Pixel>>& image) {
-    std::vector<std::vector<Pixel>> copy = image;
-    int height = image.size();
-    int width = image[0].size();
-
-    for (int i = 1; i < height - 1; ++i) {
-        for (int j = 1; j < width - 1; ++j) {
-            image[i][j].r = (copy[i - 1][j - 1].r + copy[i - 1][j].r + copy[i - 1][j + 1].r +
-                copy[i][j - 1].r + copy[i][j].r + copy[i][j + 1].r +
-                copy[i + 1][j - 1].r + copy[i + 1][j].r + copy[i + 1][j + 1].r) / 9;
-
-            image[i][j].g = (copy[i - 1][j - 1].g + copy[i - 1][j].g + copy[i - 1][j + 1].g +
-                copy[i][j - 1].g + copy[i][j].g + copy[i][j + 1].g +
-                copy[i + 1][j - 1].g + copy[i + 1][j].g + copy[i + 1][j + 1].g) / 9;
-
-            image[i][j].b = (copy[i - 1][j - 1].b + copy[i - 1][j].b + copy[i - 1][j + 1].b +
-                copy[i][j - 1].b + copy[i][j].b + copy[i][j + 1].b +
-                copy[i + 1][j - 1].b + copy[i + 1][j].b + copy[i + 1][j + 1].b) / 9;
-        }
+#include "blur.h"
+#include "cpu_features.h"
+#include "edges.h"
+#include "geometry.h"
+#include "histogram.h"
+#include "image.h"
+#include "median.h"
+#include "morphology.h"
+#include "ppm_io.h"
+#include "resize.h"
+#include "filters.h"
+#include "pipeline.h"
+
+// PPM Image processing with a filter pipeline (whole-image or tiled)
+void process_ppm_image_with_pipeline(const std::string& input_file, const std::string& output_file, const std::vector<Filter>& filters, bool tiled = false) {
+    Image image;
+    PpmHeader header;
+    IoStats read_stats;
+    if (!read_ppm(input_file, image, &header, &read_stats)) {
+        return;
     }
-}
+    print_io_stats("PPM read", read_stats);
 
-// Sharpen Filter (simple edge sharpen)
-void sharpen_filter(std::vector<std::vector<Pixel>>& image) {
-    std::vector<std::vector<Pixel>> copy = image;
-    int height = image.size();
-    int width = image[0].size();
-
-    for (int i = 1; i < height - 1; ++i) {
-        for (int j = 1; j < width - 1; ++j) {
-            int r = (copy[i][j].r * 5 - copy[i - 1][j].r - copy[i + 1][j].r - copy[i][j - 1].r - copy[i][j + 1].r);
-            int g = (copy[i][j].g * 5 - copy[i - 1][j].g - copy[i + 1][j].g - copy[i][j - 1].g - copy[i][j + 1].g);
-            int b = (copy[i][j].b * 5 - copy[i - 1][j].b - copy[i + 1][j].b - copy[i][j - 1].b - copy[i][j + 1].b);
-
-            image[i][j].r = std::clamp(r, 0, 255);
-            image[i][j].g = std::clamp(g, 0, 255);
-            image[i][j].b = std::clamp(b, 0, 255);
-        }
+    // Apply the filter pipeline
+    if (tiled) {
+        apply_pipeline_tiled(image, filters);
     }
-}
-
-// Sepia Tone Filter
-void sepia_filter(std::vector<std::vector<Pixel>>& image) {
-    for (auto& row : image) {
-        for (auto& pixel : row) {
-            unsigned char r = pixel.r;
-            unsigned char g = pixel.g;
-            unsigned char b = pixel.b;
-
-            pixel.r = std::min(255, (int)(0.393 * r + 0.769 * g + 0.189 * b));
-            pixel.g = std::min(255, (int)(0.349 * r + 0.686 * g + 0.168 * b));
-            pixel.b = std::min(255, (int)(0.272 * r + 0.534 * g + 0.131 * b));
-        }
+    else {
+        apply_pipeline(image, filters);
     }
-}
 
-// Apply multiple filters in a pipeline
-void apply_pipeline(std::vector<std::vector<Pixel>>& image, const std::vector<FilterFunction>& filters) {
-    for (const auto& filter : filters) {
-        filter(image); // Apply each filter sequentially
+    // Write the processed image back to the output file
+    IoStats write_stats;
+    if (write_ppm(output_file, image, header.max_value, &write_stats)) {
+        print_io_stats("PPM write", write_stats);
     }
 }
 
-// PPM Image processing with a filter pipeline
-void process_ppm_image_with_pipeline(const std::string& input_file, const std::string& output_file, const std::vector<FilterFunction>& filters) {
-    std::ifstream image_file(input_file, std::ios::binary);
-    if (!image_file.is_open()) {
-        std::cerr << "Error: Unable to open input PPM file." << std::endl;
+// Thumbnail of any STB-supported format: the decoded buffer is resized
+// through an ImageView, without copying it into an Image first
+void thumbnail_stb_image(const std::string& input_file, const std::string& output_file, int width, ResizeKernel kernel) {
+    int source_width, source_height, channels;
+    unsigned char* data = stbi_load(input_file.c_str(), &source_width, &source_height, &channels, STBI_rgb);
+    if (!data) {
+        std::cerr << "Error loading image: " << stbi_failure_reason() << std::endl;
         return;
     }
+    const int height = std::max(1, static_cast<int>(static_cast<long long>(width) * source_height / source_width));
+    Image thumbnail = resize_image(ImageView(data, source_width, source_height), width, height, kernel);
+    stbi_image_free(data);
+    stbi_write_jpg(output_file.c_str(), thumbnail.width(), thumbnail.height(), STBI_rgb, thumbnail.data(), 90);
+}
 
-    std::string header;
-    int width, height, max_color_value;
-
-    // Reading the PPM file header
-    image_file >> header;
-    if (header != "P6") {
-        std::cerr << "Error: Unsupported PPM format!" << std::endl;
+// Throughput of every filter at each SIMD level the CPU supports
+void benchmark_filters(const std::string& input_file, const std::vector<Filter>& filters) {
+    Image image;
+    if (!read_ppm(input_file, image)) {
         return;
     }
-    image_file >> width >> height >> max_color_value;
-    image_file.ignore();  // Skip single whitespace character after the header
-
-    std::vector<std::vector<Pixel>> image(height, std::vector<Pixel>(width));
+    const int runs = 20;
+    const double megabytes = runs * image.size_bytes() / (1024.0 * 1024.0);
 
-    // Reading pixel data
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            image_file.read(reinterpret_cast<char*>(&image[i][j]), sizeof(Pixel));
-        }
+    std::cout << "Filter throughput (MB/s), " << image.width() << "x" << image.height() << " image\n";
+    std::cout << std::setw(10) << "";
+    for (const auto& filter : filters) {
+        std::cout << std::setw(12) << filter.name;
     }
-
-    image_file.close();
-
-    // Apply the filter pipeline
-    apply_pipeline(image, filters);
-
-    // Write the processed image back to the output file
-    std::ofstream output_image(output_file, std::ios::binary);
-    output_image << "P6\n" << width << " " << height << "\n" << max_color_value << "\n";
-    for (const auto& row : image) {
-        for (const auto& pixel : row) {
-            output_image.write(reinterpret_cast<const char*>(&pixel), sizeof(Pixel));
+    std::cout << "\n";
+
+    const SimdLevel detected = detect_simd_level();
+    for (int level = 0; level <= static_cast<int>(detected); ++level) {
+        set_simd_level(static_cast<SimdLevel>(level));
+        std::cout << std::setw(10) << simd_level_name(simd_level());
+        for (const auto& filter : filters) {
+            Image work = image;
+            auto start_time = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < runs; ++i) {
+                filter.apply(work);
+            }
+            std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start_time;
+            std::cout << std::setw(12) << std::fixed << std::setprecision(0) << megabytes / duration.count();
         }
+        std::cout << "\n";
     }
-    output_image.close();
+    std::cout.unsetf(std::ios::floatfield);
+    set_simd_level(detected);
 }
 
 int main() {
     const std::string ppm_input_file = "imageP6.ppm";
     const std::string output_file_ppm = "output_ppm_pipeline.ppm";
+    const std::string output_file_ppm_stream = "output_ppm_pipeline_stream.ppm";
+    const std::string output_file_ppm_tiled = "output_ppm_pipeline_tiled.ppm";
+    const std::string output_file_ppm_borders = "output_ppm_borders.ppm";
+    const std::string output_file_ppm_box_blur = "output_ppm_box_blur.ppm";
+    const std::string output_file_ppm_gaussian = "output_ppm_gaussian.ppm";
+    const std::string output_file_ppm_sobel = "output_ppm_sobel.ppm";
+    const std::string output_file_ppm_canny = "output_ppm_canny.ppm";
+    const std::string output_file_ppm_saturation = "output_ppm_saturation.ppm";
+    const std::string output_file_ppm_median = "output_ppm_median.ppm";
+    const std::string output_file_ppm_morphology = "output_ppm_morphology.ppm";
+    const std::string output_file_ppm_equalize = "output_ppm_equalize.ppm";
+    const std::string output_file_ppm_clahe = "output_ppm_clahe.ppm";
+    const std::string output_file_ppm_otsu_levels = "output_ppm_otsu_levels.ppm";
+    const std::string output_file_ppm_thumbnail = "output_ppm_thumbnail.ppm";
+    const std::string output_file_ppm_enlarged = "output_ppm_enlarged.ppm";
+    const std::string jpg_input_file = "apple.jpg";
+    const std::string output_file_stb_thumbnail = "output_stb_thumbnail.jpg";
+    const std::string output_file_ppm_rotated = "output_ppm_rotated.ppm";
 
     // Define the filter pipeline (can add or remove filters as needed)
-    std::vector<FilterFunction> filter_pipeline = {
-        grayscale_filter,
-        invert_filter,
-       [](std::vector<std::vector<Pixel>>& img) { brightness_filter(img, 50); }, // Adjust brightness
-       [](std::vector<std::vector<Pixel>>& img) { contrast_filter(img, 1.5); }, // Adjust contrast
-       [](std::vector<std::vector<Pixel>>& img) { threshold_filter(img, 128); }, // Threshold
-        blur_filter,
-        sharpen_filter,
-        sepia_filter
+    std::vector<Filter> filter_pipeline = {
+        make_grayscale_filter(),
+        make_invert_filter(),
+        make_brightness_filter(50), // Adjust brightness
+        make_contrast_filter(1.5), // Adjust contrast
+        make_threshold_filter(128), // Threshold
+        make_blur_filter(),
+        make_sharpen_filter(),
+        make_sepia_filter()
     };
 
     // Process the PPM image using the filter pipeline
@@ -226,5 +162,131 @@ int main() {
     std::chrono::duration<double> duration = end_time - start_time;
     std::cout << "PPM with pipeline processing time: " << duration.count() << " seconds\n";
 
+    // Same pipeline in streaming mode (bounded memory, row by row)
+    start_time = std::chrono::high_resolution_clock::now();
+    stream_ppm_pipeline(ppm_input_file, output_file_ppm_stream, filter_pipeline);
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM with streaming pipeline processing time: " << duration.count() << " seconds\n";
+
+    // Same pipeline tile by tile (intermediate results stay in cache)
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_tiled, filter_pipeline, true);
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM with tiled pipeline processing time: " << duration.count() << " seconds\n";
+
+    // Stencils that also filter the border rows and columns
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_borders,
+                                    { make_blur_filter({ BorderMode::Mirror }), make_sharpen_filter({ BorderMode::Clamp }) }, true);
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM blur + sharpen with border modes time: " << duration.count() << " seconds\n";
+
+    // Large-radius blur: cost does not depend on the radius
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_box_blur, { make_box_blur_filter(20, 3) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM box blur (radius 20, 3 passes) time: " << duration.count() << " seconds\n";
+
+    // Gaussian blur (recursive filter for a sigma this large)
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_gaussian, { make_gaussian_blur_filter(8.0f) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM gaussian blur (sigma 8) time: " << duration.count() << " seconds\n";
+
+    // Edge detection: Sobel gradient, and Canny after a light Gaussian blur
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_sobel, { make_sobel_filter() });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM sobel edges time: " << duration.count() << " seconds\n";
+
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_canny, { make_gaussian_blur_filter(1.4f), make_canny_filter() });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM canny edges time: " << duration.count() << " seconds\n";
+
+    // Saturation boost (fixed-point luma blend)
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_saturation, { make_saturation_filter(1.8f) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM saturation time: " << duration.count() << " seconds\n";
+
+    // Noise removal: constant-time median, radius 3
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_median, { make_median_filter(3) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM median (radius 3) time: " << duration.count() << " seconds\n";
+
+    // Binary cleanup: Otsu threshold, then open away specks and close small holes
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_morphology,
+                                    { make_otsu_threshold_filter(), make_open_filter(3, 3), make_close_filter(5, 5) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM threshold + open / close time: " << duration.count() << " seconds\n";
+
+    // Histogram equalization: global, and per 8 x 8 tiles with clipping (CLAHE)
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_equalize, { make_equalize_filter() });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM histogram equalization time: " << duration.count() << " seconds\n";
+
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_clahe, { make_clahe_filter(8, 8, 2.0f) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM CLAHE (8 x 8 tiles, clip 2) time: " << duration.count() << " seconds\n";
+
+    // Four gray levels from three Otsu thresholds
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_otsu_levels, { make_otsu_multilevel_filter(3) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM multi-level Otsu (3 thresholds) time: " << duration.count() << " seconds\n";
+
+    // Resize: Lanczos thumbnail, bicubic enlargement, and a thumbnail of a JPG
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_thumbnail, { make_resize_filter(64, 64, ResizeKernel::Lanczos3) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM thumbnail (64 x 64, Lanczos) time: " << duration.count() << " seconds\n";
+
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_enlarged, { make_resize_filter(1024, 1024, ResizeKernel::Bicubic) });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM enlarge (1024 x 1024, bicubic) time: " << duration.count() << " seconds\n";
+
+    start_time = std::chrono::high_resolution_clock::now();
+    thumbnail_stb_image(jpg_input_file, output_file_stb_thumbnail, 160, ResizeKernel::Lanczos3);
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "STB thumbnail (160 wide, Lanczos) time: " << duration.count() << " seconds\n";
+
+    // Quarter turn clockwise, then a mirror image
+    start_time = std::chrono::high_resolution_clock::now();
+    process_ppm_image_with_pipeline(ppm_input_file, output_file_ppm_rotated,
+                                    { make_rotate_filter(Rotation::Rotate90), make_flip_horizontal_filter() });
+    end_time = std::chrono::high_resolution_clock::now();
+    duration = end_time - start_time;
+    std::cout << "PPM rotate 90 + flip time: " << duration.count() << " seconds\n";
+
+    std::vector<Filter> benchmarked = filter_pipeline;
+    benchmarked.push_back(make_saturation_filter(1.8f));
+    // Floating-point sepia, to compare with the fixed-point one above
+    Filter sepia_reference = make_sepia_filter(Arithmetic::Reference);
+    sepia_reference.name = "sepia-float";
+    benchmarked.push_back(sepia_reference);
+    benchmark_filters(ppm_input_file, benchmarked);
+
     return 0;
 }
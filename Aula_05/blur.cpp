@@ -0,0 +1,416 @@
+#include "blur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "parallel.h"
+
+namespace {
+
+// Width of the column strips of the vertical pass (192 bytes, 3 cache lines)
+constexpr int kStripPixels = 64;
+
+// Mean of the window, rounded. Sums stay below 2^24, so they are exact floats.
+inline unsigned char window_mean(int sum, float scale) {
+    return static_cast<unsigned char>(sum * scale + 0.5f);
+}
+
+// Horizontal box blur of one row, from `src` (a copy of the row) into `dst`
+void box_blur_row(const unsigned char* src, unsigned char* dst, int width, int radius, float scale) {
+    const int last = width - 1;
+
+    // Window of pixel 0: r + 1 copies of the left edge plus pixels 1 .. r
+    int sum[3];
+    for (int c = 0; c < 3; ++c) {
+        sum[c] = (radius + 1) * src[c];
+    }
+    for (int i = 1; i <= std::min(radius, last); ++i) {
+        for (int c = 0; c < 3; ++c) {
+            sum[c] += src[3 * i + c];
+        }
+    }
+    if (radius > last) {
+        for (int c = 0; c < 3; ++c) {
+            sum[c] += (radius - last) * src[3 * last + c];
+        }
+    }
+
+    for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < 3; ++c) {
+            dst[3 * x + c] = window_mean(sum[c], scale);
+        }
+        // Slide the window: pixel x + r + 1 comes in, pixel x - r goes out
+        const unsigned char* in = src + 3 * std::min(x + radius + 1, last);
+        const unsigned char* out = src + 3 * std::max(x - radius, 0);
+        for (int c = 0; c < 3; ++c) {
+            sum[c] += in[c] - out[c];
+        }
+    }
+}
+
+// Vertical box blur, in place, of the columns [x0, x1) (at most one strip).
+// One running sum per byte of the strip, kept in a local array so the
+// compiler can see it does not alias the image and vectorize the loops;
+// `ring` keeps the original rows y - r .. y that have already been overwritten.
+void box_blur_columns(Image& image, int x0, int x1, int radius, float scale) {
+    const int height = image.height();
+    const int last = height - 1;
+    const int bytes = 3 * (x1 - x0);
+    auto strip = [&](int y) { return reinterpret_cast<unsigned char*>(image.row(y) + x0); };
+
+    int sums[3 * kStripPixels];
+    std::vector<unsigned char> ring(static_cast<std::size_t>(radius + 1) * bytes);
+
+    const unsigned char* top = strip(0);
+    for (int j = 0; j < bytes; ++j) {
+        sums[j] = (radius + 1) * top[j];
+    }
+    for (int i = 1; i <= std::min(radius, last); ++i) {
+        const unsigned char* row = strip(i);
+        for (int j = 0; j < bytes; ++j) {
+            sums[j] += row[j];
+        }
+    }
+    if (radius > last) {
+        const unsigned char* bottom = strip(last);
+        for (int j = 0; j < bytes; ++j) {
+            sums[j] += (radius - last) * bottom[j];
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        unsigned char* row = strip(y);
+        std::memcpy(&ring[static_cast<std::size_t>(y % (radius + 1)) * bytes], row, bytes);
+        for (int j = 0; j < bytes; ++j) {
+            row[j] = window_mean(sums[j], scale);
+        }
+        if (y == last) {
+            break;
+        }
+        // Row y + r + 1 is still original; row y - r comes from the ring
+        const unsigned char* in = strip(std::min(y + radius + 1, last));
+        const unsigned char* out = &ring[static_cast<std::size_t>(std::max(y - radius, 0) % (radius + 1)) * bytes];
+        for (int j = 0; j < bytes; ++j) {
+            sums[j] += in[j] - out[j];
+        }
+    }
+}
+
+// Gaussian FIR: taps in 14-bit fixed point, summing to exactly 1 << 14
+constexpr int kFirShift = 14;
+
+std::vector<int> gaussian_taps(float sigma) {
+    const int radius = std::max(1, static_cast<int>(std::ceil(3.0f * sigma)));
+    std::vector<double> weights(2 * radius + 1);
+    double total = 0.0;
+    for (int k = -radius; k <= radius; ++k) {
+        weights[k + radius] = std::exp(-0.5 * k * k / (static_cast<double>(sigma) * sigma));
+        total += weights[k + radius];
+    }
+    std::vector<int> taps(weights.size());
+    int sum = 0;
+    for (std::size_t i = 0; i < taps.size(); ++i) {
+        taps[i] = static_cast<int>(std::lround(weights[i] / total * (1 << kFirShift)));
+        sum += taps[i];
+    }
+    taps[radius] += (1 << kFirShift) - sum; // unit gain, so flat areas stay unchanged
+    return taps;
+}
+
+// acc[j] = rounding + sum over k of taps[k] * rows[k][j], then back to bytes
+void fir_accumulate(const std::vector<int>& taps, const unsigned char* const* rows, int bytes, int* acc, unsigned char* dst) {
+    for (int j = 0; j < bytes; ++j) {
+        acc[j] = 1 << (kFirShift - 1);
+    }
+    for (std::size_t k = 0; k < taps.size(); ++k) {
+        const int tap = taps[k];
+        const unsigned char* src = rows[k];
+        for (int j = 0; j < bytes; ++j) {
+            acc[j] += tap * src[j];
+        }
+    }
+    for (int j = 0; j < bytes; ++j) {
+        dst[j] = static_cast<unsigned char>(acc[j] >> kFirShift);
+    }
+}
+
+// Horizontal FIR of one row. `padded` gets the row with r copies of the
+// edge pixels on each side, so the taps are just byte offsets 3k into it.
+void fir_row(unsigned char* row, int width, const std::vector<int>& taps,
+             std::vector<unsigned char>& padded, std::vector<int>& acc, std::vector<const unsigned char*>& offsets) {
+    const int radius = static_cast<int>(taps.size() / 2);
+    const int bytes = 3 * width;
+    for (int i = 0; i < radius; ++i) {
+        std::memcpy(&padded[3 * i], row, 3);
+        std::memcpy(&padded[3 * (radius + width + i)], row + bytes - 3, 3);
+    }
+    std::memcpy(&padded[3 * radius], row, bytes);
+    for (std::size_t k = 0; k < taps.size(); ++k) {
+        offsets[k] = &padded[3 * k];
+    }
+    fir_accumulate(taps, offsets.data(), bytes, acc.data(), row);
+}
+
+// Vertical FIR, in place, of the columns [x0, x1) (at most one strip).
+// `ring` holds the original rows y - r .. y + r of the strip.
+void fir_columns(Image& image, int x0, int x1, const std::vector<int>& taps) {
+    const int radius = static_cast<int>(taps.size() / 2);
+    const int window = 2 * radius + 1;
+    const int last = image.height() - 1;
+    const int bytes = 3 * (x1 - x0);
+    auto strip = [&](int y) { return reinterpret_cast<unsigned char*>(image.row(y) + x0); };
+
+    std::vector<unsigned char> ring(static_cast<std::size_t>(window) * bytes);
+    auto slot = [&](int i) { return &ring[static_cast<std::size_t>((i + radius) % window) * bytes]; };
+    for (int i = -radius; i < radius; ++i) {
+        std::memcpy(slot(i), strip(std::clamp(i, 0, last)), bytes);
+    }
+
+    int acc[3 * kStripPixels];
+    std::vector<const unsigned char*> rows(window);
+    for (int y = 0; y <= last; ++y) {
+        // Rows after y are still original
+        std::memcpy(slot(y + radius), strip(std::min(y + radius, last)), bytes);
+        for (int k = 0; k < window; ++k) {
+            rows[k] = slot(y - radius + k);
+        }
+        fir_accumulate(taps, rows.data(), bytes, acc, strip(y));
+    }
+}
+
+// Gaussian IIR (Young & van Vliet, 1995): w[n] = b x[n] + a1 w[n-1] + a2 w[n-2] + a3 w[n-3],
+// forwards and then backwards over the forward result
+struct IirCoefficients {
+    float b, a1, a2, a3;
+};
+
+IirCoefficients young_van_vliet(float sigma) {
+    const double q = (sigma >= 2.5f) ? 0.98711 * sigma - 0.96330
+                                     : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+    const double q2 = q * q;
+    const double q3 = q2 * q;
+    const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+    const double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+    const double b2 = -(1.4281 * q2 + 1.26661 * q3);
+    const double b3 = 0.422205 * q3;
+
+    IirCoefficients k;
+    k.a1 = static_cast<float>(b1 / b0);
+    k.a2 = static_cast<float>(b2 / b0);
+    k.a3 = static_cast<float>(b3 / b0);
+    k.b = 1.0f - (k.a1 + k.a2 + k.a3);
+    return k;
+}
+
+inline unsigned char clamp_to_byte(float value) {
+    return static_cast<unsigned char>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+}
+
+// Samples of the edge value the forward pass runs past the end, so the
+// backward pass starts where the response to the replicated edge has settled
+int iir_padding(float sigma) {
+    return static_cast<int>(std::ceil(4.0f * sigma));
+}
+
+// Horizontal IIR of one row. The forward pass starts in the steady state of
+// the left edge value (an infinite run of it) and continues `padding` pixels
+// past the right edge; the three channels are three independent recursions.
+void iir_row(unsigned char* row, int width, int padding, const IirCoefficients& k, std::vector<float>& forward) {
+    const int last = width - 1;
+    const int end = last + padding;
+    float w1[3], w2[3], w3[3];
+    for (int c = 0; c < 3; ++c) {
+        w1[c] = w2[c] = w3[c] = row[c];
+    }
+    for (int x = 0; x <= end; ++x) {
+        const unsigned char* in = row + 3 * std::min(x, last);
+        for (int c = 0; c < 3; ++c) {
+            float w = k.b * in[c] + k.a1 * w1[c] + k.a2 * w2[c] + k.a3 * w3[c];
+            forward[3 * x + c] = w;
+            w3[c] = w2[c];
+            w2[c] = w1[c];
+            w1[c] = w;
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        w1[c] = w2[c] = w3[c] = forward[3 * end + c];
+    }
+    for (int x = end; x > last; --x) {
+        for (int c = 0; c < 3; ++c) {
+            float w = k.b * forward[3 * x + c] + k.a1 * w1[c] + k.a2 * w2[c] + k.a3 * w3[c];
+            w3[c] = w2[c];
+            w2[c] = w1[c];
+            w1[c] = w;
+        }
+    }
+    for (int x = last; x >= 0; --x) {
+        for (int c = 0; c < 3; ++c) {
+            float w = k.b * forward[3 * x + c] + k.a1 * w1[c] + k.a2 * w2[c] + k.a3 * w3[c];
+            row[3 * x + c] = clamp_to_byte(w);
+            w3[c] = w2[c];
+            w2[c] = w1[c];
+            w1[c] = w;
+        }
+    }
+}
+
+// Vertical IIR of the columns [x0, x1): one recursion per byte of the strip,
+// advanced a row at a time, with the same edge handling as iir_row.
+// `forward` receives the whole strip's forward pass.
+void iir_columns(Image& image, int x0, int x1, int padding, const IirCoefficients& k, std::vector<float>& forward) {
+    const int last = image.height() - 1;
+    const int end = last + padding;
+    const int bytes = 3 * (x1 - x0);
+    auto strip = [&](int y) { return reinterpret_cast<unsigned char*>(image.row(y) + x0); };
+    forward.resize(static_cast<std::size_t>(end + 1) * bytes);
+
+    float w1[3 * kStripPixels], w2[3 * kStripPixels], w3[3 * kStripPixels];
+    const unsigned char* top = strip(0);
+    for (int j = 0; j < bytes; ++j) {
+        w1[j] = w2[j] = w3[j] = top[j];
+    }
+    for (int y = 0; y <= end; ++y) {
+        const unsigned char* src = strip(std::min(y, last));
+        float* dst = &forward[static_cast<std::size_t>(y) * bytes];
+        for (int j = 0; j < bytes; ++j) {
+            float w = k.b * src[j] + k.a1 * w1[j] + k.a2 * w2[j] + k.a3 * w3[j];
+            dst[j] = w;
+            w3[j] = w2[j];
+            w2[j] = w1[j];
+            w1[j] = w;
+        }
+    }
+
+    const float* bottom = &forward[static_cast<std::size_t>(end) * bytes];
+    for (int j = 0; j < bytes; ++j) {
+        w1[j] = w2[j] = w3[j] = bottom[j];
+    }
+    for (int y = end; y > last; --y) {
+        const float* src = &forward[static_cast<std::size_t>(y) * bytes];
+        for (int j = 0; j < bytes; ++j) {
+            float w = k.b * src[j] + k.a1 * w1[j] + k.a2 * w2[j] + k.a3 * w3[j];
+            w3[j] = w2[j];
+            w2[j] = w1[j];
+            w1[j] = w;
+        }
+    }
+    for (int y = last; y >= 0; --y) {
+        const float* src = &forward[static_cast<std::size_t>(y) * bytes];
+        unsigned char* dst = strip(y);
+        for (int j = 0; j < bytes; ++j) {
+            float w = k.b * src[j] + k.a1 * w1[j] + k.a2 * w2[j] + k.a3 * w3[j];
+            dst[j] = clamp_to_byte(w);
+            w3[j] = w2[j];
+            w2[j] = w1[j];
+            w1[j] = w;
+        }
+    }
+}
+
+int strip_count(const Image& image) {
+    return (image.width() + kStripPixels - 1) / kStripPixels;
+}
+
+int strip_end(const Image& image, int s) {
+    return std::min(image.width(), (s + 1) * kStripPixels);
+}
+
+} // namespace
+
+void box_blur(Image& image, int radius, int passes, int num_threads) {
+    radius = std::min(radius, kMaxBoxBlurRadius);
+    if (radius <= 0 || passes <= 0 || image.empty()) {
+        return;
+    }
+    const int width = image.width();
+    const int height = image.height();
+    const float scale = 1.0f / (2 * radius + 1);
+    const int strips = strip_count(image);
+
+    for (int pass = 0; pass < passes; ++pass) {
+        parallel_for(0, height, num_threads, [&](int start, int stop) {
+            std::vector<unsigned char> src(3 * static_cast<std::size_t>(width));
+            for (int y = start; y < stop; ++y) {
+                unsigned char* row = reinterpret_cast<unsigned char*>(image.row(y));
+                std::memcpy(src.data(), row, src.size());
+                box_blur_row(src.data(), row, width, radius, scale);
+            }
+        });
+
+        parallel_for(0, strips, num_threads, [&](int start, int stop) {
+            for (int s = start; s < stop; ++s) {
+                box_blur_columns(image, s * kStripPixels, strip_end(image, s), radius, scale);
+            }
+        });
+    }
+}
+
+Filter make_box_blur_filter(int radius, int passes) {
+    Filter filter([radius, passes](Image& image) { box_blur(image, radius, passes); });
+    filter.name = "box blur";
+    return filter;
+}
+
+void gaussian_blur(Image& image, float sigma, int num_threads) {
+    if (sigma < kGaussianIirSigma) {
+        gaussian_blur_fir(image, sigma, num_threads);
+    }
+    else {
+        gaussian_blur_iir(image, sigma, num_threads);
+    }
+}
+
+void gaussian_blur_fir(Image& image, float sigma, int num_threads) {
+    if (!(sigma > 0.0f) || image.empty()) {
+        return;
+    }
+    const std::vector<int> taps = gaussian_taps(sigma);
+    const int width = image.width();
+    const int radius = static_cast<int>(taps.size() / 2);
+
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        std::vector<unsigned char> padded(3 * static_cast<std::size_t>(width + 2 * radius));
+        std::vector<int> acc(3 * static_cast<std::size_t>(width));
+        std::vector<const unsigned char*> offsets(taps.size());
+        for (int y = start; y < stop; ++y) {
+            fir_row(reinterpret_cast<unsigned char*>(image.row(y)), width, taps, padded, acc, offsets);
+        }
+    });
+
+    parallel_for(0, strip_count(image), num_threads, [&](int start, int stop) {
+        for (int s = start; s < stop; ++s) {
+            fir_columns(image, s * kStripPixels, strip_end(image, s), taps);
+        }
+    });
+}
+
+void gaussian_blur_iir(Image& image, float sigma, int num_threads) {
+    if (!(sigma > 0.0f) || image.empty()) {
+        return;
+    }
+    const IirCoefficients k = young_van_vliet(sigma);
+    const int width = image.width();
+    const int padding = iir_padding(sigma);
+
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        std::vector<float> forward(3 * static_cast<std::size_t>(width + padding));
+        for (int y = start; y < stop; ++y) {
+            iir_row(reinterpret_cast<unsigned char*>(image.row(y)), width, padding, k, forward);
+        }
+    });
+
+    parallel_for(0, strip_count(image), num_threads, [&](int start, int stop) {
+        std::vector<float> forward;
+        for (int s = start; s < stop; ++s) {
+            iir_columns(image, s * kStripPixels, strip_end(image, s), padding, k, forward);
+        }
+    });
+}
+
+Filter make_gaussian_blur_filter(float sigma) {
+    Filter filter([sigma](Image& image) { gaussian_blur(image, sigma); });
+    filter.name = "gaussian blur";
+    return filter;
+}
@@ -0,0 +1,44 @@
+#ifndef _BLUR_H
+#define _BLUR_H
+
+#include "filters.h"
+#include "image.h"
+
+// Largest radius box_blur accepts (larger ones are clamped)
+constexpr int kMaxBoxBlurRadius = 16383;
+
+// Box blur: mean over a (2r + 1) x (2r + 1) window, done as a horizontal and
+// a vertical pass with running sums, so every output costs one add and one
+// subtract per channel whatever the radius. Repeating it `passes` times
+// approaches a Gaussian (3 passes are already close). Pixels outside the
+// image take the value of the nearest edge pixel.
+//
+// The horizontal pass splits the rows between threads; the vertical pass
+// splits the image into column strips of 64 pixels, and each thread walks
+// down its strips keeping only the last r + 1 original rows of the strip,
+// so it works in place and stays in cache.
+void box_blur(Image& image, int radius, int passes = 1, int num_threads = 0);
+
+Filter make_box_blur_filter(int radius, int passes = 1);
+
+// Sigma from which gaussian_blur switches from the FIR to the IIR version
+constexpr float kGaussianIirSigma = 3.0f;
+
+// Gaussian blur with standard deviation `sigma` (pixels); edges as above.
+// Both versions are separable, with rows split between threads and columns
+// done in strips of 64 pixels, one vector lane per column.
+//
+// gaussian_blur_fir: 14-bit fixed-point kernel of radius ceil(3 sigma),
+// exact for small sigma but its cost grows with sigma.
+// gaussian_blur_iir: third-order recursive filter (Young & van Vliet), run
+// forwards then backwards; a constant 8 multiply-adds per channel and axis
+// whatever the sigma, within a few levels of the exact Gaussian.
+// gaussian_blur picks the FIR below kGaussianIirSigma and the IIR above.
+void gaussian_blur(Image& image, float sigma, int num_threads = 0);
+void gaussian_blur_fir(Image& image, float sigma, int num_threads = 0);
+void gaussian_blur_iir(Image& image, float sigma, int num_threads = 0);
+
+Filter make_gaussian_blur_filter(float sigma);
+
+
+#endif // !_BLUR_H
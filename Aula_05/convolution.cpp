@@ -0,0 +1,47 @@
+#include "convolution.h"
+
+namespace {
+
+// Bytes accumulated at a time by the run-time kernel (fits in L1 with the taps)
+constexpr int kChunkBytes = 512;
+
+} // namespace
+
+void convolve_row(const RuntimeConvolutionKernel& kernel, const Pixel* const* rows, Pixel* out, int width) {
+    const int size = kernel.size;
+    const int radius = kernel.radius();
+    convolution_detail::copy_border_columns(rows[radius], out, width, radius);
+
+    unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+    const int end = 3 * (width - radius);
+    int acc[kChunkBytes];
+
+    // Tap by tap over a chunk of the row: the inner loop is a plain
+    // multiply-add over consecutive bytes
+    for (int begin = 3 * radius; begin < end; begin += kChunkBytes) {
+        const int count = std::min(kChunkBytes, end - begin);
+        std::fill(acc, acc + count, 0);
+        for (int dy = 0; dy < size; ++dy) {
+            const unsigned char* src = reinterpret_cast<const unsigned char*>(rows[dy]) + begin;
+            for (int dx = -radius; dx <= radius; ++dx) {
+                const int weight = kernel.weights[dy * size + dx + radius];
+                if (weight == 0) {
+                    continue;
+                }
+                const unsigned char* tap = src + 3 * dx;
+                for (int j = 0; j < count; ++j) {
+                    acc[j] += weight * tap[j];
+                }
+            }
+        }
+        for (int j = 0; j < count; ++j) {
+            dst[begin + j] = static_cast<unsigned char>(std::clamp(acc[j] / kernel.divisor, 0, 255));
+        }
+    }
+}
+
+Filter make_convolution_filter(const std::string& name, const RuntimeConvolutionKernel& kernel, Border border) {
+    return make_stencil_filter(name, kernel.radius(), [kernel](const Pixel* const* rows, Pixel* out, int width) {
+        convolve_row(kernel, rows, out, width);
+    }, border);
+}
@@ -0,0 +1,131 @@
+#ifndef _CONVOLUTION_H
+#define _CONVOLUTION_H
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "filters.h"
+#include "image.h"
+
+// Convolution engine
+//
+// A Size x Size integer kernel: every output channel is
+// clamp(sum(weight * input) / divisor, 0, 255), with the division truncating
+// like C++ integer division. As a StencilKernel of radius Size / 2, columns
+// (and, through apply_stencil_kernel, rows) closer than the radius to the
+// edge are left unchanged, unless the filter is given a border mode.
+//
+// convolve_row<K> takes the kernel as a template argument: the taps are
+// unrolled at compile time, zero weights disappear, the division by a
+// constant becomes a multiply, and the loop over the bytes of the row is
+// left simple enough for the compiler to vectorize. convolve_row(kernel, ...)
+// is the fallback for kernels only known at run time.
+
+template <int Size>
+struct ConvolutionKernel {
+    static_assert(Size % 2 == 1, "Convolution kernels have an odd size");
+
+    std::array<int, Size * Size> weights; // row-major
+    int divisor = 1;
+
+    static constexpr int size() { return Size; }
+    static constexpr int radius() { return Size / 2; }
+};
+
+struct RuntimeConvolutionKernel {
+    int size = 1;
+    std::vector<int> weights; // size * size, row-major
+    int divisor = 1;
+
+    int radius() const { return size / 2; }
+};
+
+constexpr ConvolutionKernel<3> kBlur3x3 = { { 1, 1, 1,
+                                              1, 1, 1,
+                                              1, 1, 1 }, 9 };
+constexpr ConvolutionKernel<3> kSharpen3x3 = { { 0, -1, 0,
+                                                 -1, 5, -1,
+                                                 0, -1, 0 }, 1 };
+constexpr ConvolutionKernel<5> kGaussian5x5 = { { 1, 4, 6, 4, 1,
+                                                  4, 16, 24, 16, 4,
+                                                  6, 24, 36, 24, 6,
+                                                  4, 16, 24, 16, 4,
+                                                  1, 4, 6, 4, 1 }, 256 };
+constexpr ConvolutionKernel<7> kBox7x7 = { { 1, 1, 1, 1, 1, 1, 1,
+                                             1, 1, 1, 1, 1, 1, 1,
+                                             1, 1, 1, 1, 1, 1, 1,
+                                             1, 1, 1, 1, 1, 1, 1,
+                                             1, 1, 1, 1, 1, 1, 1,
+                                             1, 1, 1, 1, 1, 1, 1,
+                                             1, 1, 1, 1, 1, 1, 1 }, 49 };
+
+namespace convolution_detail {
+
+// Columns closer than r to the left or right edge are copied from the centre row
+inline void copy_border_columns(const Pixel* centre, Pixel* out, int width, int radius) {
+    const int left = std::min(radius, width);
+    for (int x = 0; x < left; ++x) {
+        out[x] = centre[x];
+    }
+    for (int x = std::max(width - radius, left); x < width; ++x) {
+        out[x] = centre[x];
+    }
+}
+
+// weight * input for tap I (row I / Size, column I % Size) at byte i
+template <ConvolutionKernel K, std::size_t I>
+inline int tap(const unsigned char* const* src, int i) {
+    constexpr int weight = K.weights[I];
+    if constexpr (weight == 0) {
+        return 0;
+    }
+    else {
+        constexpr int dy = static_cast<int>(I) / K.size();
+        constexpr int dx = static_cast<int>(I) % K.size() - K.radius();
+        return weight * src[dy][i + 3 * dx];
+    }
+}
+
+template <ConvolutionKernel K, std::size_t... I>
+inline int tap_sum(const unsigned char* const* src, int i, std::index_sequence<I...>) {
+    return (0 + ... + tap<K, I>(src, i));
+}
+
+} // namespace convolution_detail
+
+template <ConvolutionKernel K>
+void convolve_row(const Pixel* const* rows, Pixel* out, int width) {
+    constexpr int radius = K.radius();
+    convolution_detail::copy_border_columns(rows[radius], out, width, radius);
+
+    const unsigned char* src[K.size()];
+    for (int k = 0; k < K.size(); ++k) {
+        src[k] = reinterpret_cast<const unsigned char*>(rows[k]);
+    }
+    unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+
+    // Channels are interleaved, so the taps are byte offsets 3 * dx
+    const int end = 3 * (width - radius);
+    for (int i = 3 * radius; i < end; ++i) {
+        int sum = convolution_detail::tap_sum<K>(src, i, std::make_index_sequence<K.weights.size()>());
+        if constexpr (K.divisor != 1) {
+            sum /= K.divisor;
+        }
+        dst[i] = static_cast<unsigned char>(std::clamp(sum, 0, 255));
+    }
+}
+
+void convolve_row(const RuntimeConvolutionKernel& kernel, const Pixel* const* rows, Pixel* out, int width);
+
+template <ConvolutionKernel K>
+Filter make_convolution_filter(const std::string& name, Border border = {}) {
+    return make_stencil_filter(name, K.radius(), convolve_row<K>, border);
+}
+
+Filter make_convolution_filter(const std::string& name, const RuntimeConvolutionKernel& kernel, Border border = {});
+
+
+#endif // !_CONVOLUTION_H
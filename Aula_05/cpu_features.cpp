@@ -0,0 +1,116 @@
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+#ifdef CPU_FEATURES_X86
+// Registers eax, ebx, ecx, edx of cpuid(leaf, subleaf)
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<unsigned>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switches (XCR0)
+unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+SimdLevel probe_simd_level() {
+#ifdef CPU_FEATURES_X86
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    unsigned max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    bool sse2 = (regs[3] >> 26) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx = (regs[2] >> 28) & 1;
+    if (!sse2) {
+        return SimdLevel::Scalar;
+    }
+    if (!osxsave || !avx || max_leaf < 7) {
+        return SimdLevel::SSE2;
+    }
+
+    // The OS must save the YMM (and for AVX-512 the opmask / ZMM) registers
+    unsigned long long xcr0 = xgetbv0();
+    bool ymm_state = (xcr0 & 0x6) == 0x6;
+    bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid(7, 0, regs);
+    bool avx2 = (regs[1] >> 5) & 1;
+    bool avx512f = (regs[1] >> 16) & 1;
+    bool avx512bw = (regs[1] >> 30) & 1;
+
+    if (avx2 && avx512f && avx512bw && zmm_state) {
+        return SimdLevel::AVX512;
+    }
+    if (avx2 && ymm_state) {
+        return SimdLevel::AVX2;
+    }
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+std::atomic<int>& current_level() {
+    static std::atomic<int> level(static_cast<int>(detect_simd_level()));
+    return level;
+}
+
+} // namespace
+
+SimdLevel detect_simd_level() {
+    static const SimdLevel level = probe_simd_level();
+    return level;
+}
+
+SimdLevel simd_level() {
+    return static_cast<SimdLevel>(current_level().load(std::memory_order_relaxed));
+}
+
+void set_simd_level(SimdLevel level) {
+    level = std::min(level, detect_simd_level());
+    current_level().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE2:
+        return "SSE2";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    }
+    return "unknown";
+}
@@ -0,0 +1,24 @@
+#ifndef _CPU_FEATURES_H
+#define _CPU_FEATURES_H
+
+// Instruction sets the vectorized filters can use, from slowest to fastest
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512 // AVX-512 F + BW
+};
+
+// Best level supported by both the CPU and the OS (probed once with cpuid)
+SimdLevel detect_simd_level();
+
+// Level the filters currently run at. Starts at detect_simd_level();
+// set_simd_level() can lower it (e.g. to compare ISAs) but never raise it
+// above what the machine supports.
+SimdLevel simd_level();
+void set_simd_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
+
+
+#endif // !_CPU_FEATURES_H
@@ -0,0 +1,294 @@
+#include "edges.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "filters_simd.h"
+#include "parallel.h"
+
+namespace {
+
+// Pixels converted to 16-bit gray at a time by sobel_row
+constexpr int kChunkPixels = 256;
+
+// Classes of the Canny edge map. Strong pixels are seeds not yet followed.
+constexpr unsigned char kNoEdge = 0;
+constexpr unsigned char kWeak = 1;
+constexpr unsigned char kStrong = 2;
+constexpr unsigned char kEdge = 255;
+
+// r + g + b of `count` pixels: 3x the gray level, kept whole so no division
+// is needed until the magnitude is written out
+void gray_sums(const Pixel* row, short* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        out[i] = static_cast<short>(row[i].r + row[i].g + row[i].b);
+    }
+}
+
+// |gx| + |gy| of gray sums back on the 0 .. 255 scale
+inline int sobel_magnitude(int magnitude3) {
+    return std::min(magnitude3 / 3, 255);
+}
+
+// Gradient of one image row with edge replication, plus its magnitude and
+// direction sector: 0 horizontal, 2 vertical, 1 and 3 the diagonals
+class CannyBand
+{
+public:
+    CannyBand(const Image& image)
+        : m_Image(image), m_Width(image.width()), m_Height(image.height()),
+          m_Gray(3 * (m_Width + 2)), m_Gx(m_Width), m_Gy(m_Width),
+          m_Magnitude(3 * m_Width), m_Direction(3 * m_Width) {}
+
+    // Magnitudes and directions of row y (0 <= y < height), computed on demand;
+    // valid while rows are requested in increasing order, at most 3 apart
+    const short* magnitude(int y) {
+        update_gradient(y);
+        return m_Magnitude.data() + (y % 3) * m_Width;
+    }
+    const unsigned char* direction(int y) {
+        update_gradient(y);
+        return m_Direction.data() + (y % 3) * m_Width;
+    }
+
+private:
+    int clamp_row(int y) const { return std::clamp(y, 0, m_Height - 1); }
+
+    // Gray sums of row y with one replicated pixel on either side;
+    // the returned pointer is to pixel 0
+    const short* gray(int y) {
+        const int slot = y % 3;
+        short* row = m_Gray.data() + slot * (m_Width + 2);
+        if (m_GrayRow[slot] != y) {
+            gray_sums(m_Image.row(y), row + 1, m_Width);
+            row[0] = row[1];
+            row[m_Width + 1] = row[m_Width];
+            m_GrayRow[slot] = y;
+        }
+        return row + 1;
+    }
+
+    void update_gradient(int y) {
+        const int slot = y % 3;
+        if (m_GradientRow[slot] == y) {
+            return;
+        }
+        const short* up = gray(clamp_row(y - 1));
+        const short* mid = gray(y);
+        const short* down = gray(clamp_row(y + 1));
+        active_row_kernels().sobel(up, mid, down, m_Gx.data(), m_Gy.data(), m_Width);
+
+        short* magnitude = m_Magnitude.data() + slot * m_Width;
+        unsigned char* direction = m_Direction.data() + slot * m_Width;
+        for (int x = 0; x < m_Width; ++x) {
+            const int gx = m_Gx[x];
+            const int gy = m_Gy[x];
+            const int ax = std::abs(gx);
+            const int ay = std::abs(gy);
+            magnitude[x] = static_cast<short>(ax + ay);
+            // tan(22.5) and tan(67.5) degrees in 15-bit fixed point
+            if ((ay << 15) <= ax * 13573) {
+                direction[x] = 0;
+            }
+            else if ((ay << 15) >= ax * 79109) {
+                direction[x] = 2;
+            }
+            else {
+                direction[x] = ((gx ^ gy) >= 0) ? 1 : 3;
+            }
+        }
+        m_GradientRow[slot] = y;
+    }
+
+    const Image& m_Image;
+    int m_Width;
+    int m_Height;
+    std::vector<short> m_Gray;
+    std::vector<short> m_Gx;
+    std::vector<short> m_Gy;
+    std::vector<short> m_Magnitude;
+    std::vector<unsigned char> m_Direction;
+    int m_GrayRow[3] = { -1, -1, -1 };
+    int m_GradientRow[3] = { -1, -1, -1 };
+};
+
+// Non-maximum suppression of row y (0 < y < height - 1) into its row of the
+// edge map: local maxima above `low` become weak, above `high` strong
+void suppress_row(CannyBand& band, int y, int width, int low, int high, unsigned char* classes) {
+    const short* above = band.magnitude(y - 1);
+    const short* here = band.magnitude(y);
+    const short* below = band.magnitude(y + 1);
+    const unsigned char* direction = band.direction(y);
+
+    classes[0] = kNoEdge;
+    classes[width - 1] = kNoEdge;
+    for (int x = 1; x < width - 1; ++x) {
+        const int m = here[x];
+        if (m <= low) {
+            classes[x] = kNoEdge;
+            continue;
+        }
+        int before;
+        int after;
+        switch (direction[x]) {
+        case 0:
+            before = here[x - 1];
+            after = here[x + 1];
+            break;
+        case 1:
+            before = above[x - 1];
+            after = below[x + 1];
+            break;
+        case 2:
+            before = above[x];
+            after = below[x];
+            break;
+        default:
+            before = above[x + 1];
+            after = below[x - 1];
+            break;
+        }
+        // Strict on one side only, so a plateau two pixels wide keeps one
+        if (m > before && m >= after) {
+            classes[x] = (m > high) ? kStrong : kWeak;
+        }
+        else {
+            classes[x] = kNoEdge;
+        }
+    }
+}
+
+// Follow edges from (x, y) through 8-connected weak or strong pixels of rows
+// [y0, y1), marking them as edges
+void follow_edges(unsigned char* classes, int width, int y0, int y1, int x, int y, std::vector<int>& stack) {
+    classes[y * width + x] = kEdge;
+    stack.push_back(y * width + x);
+    while (!stack.empty()) {
+        const int index = stack.back();
+        stack.pop_back();
+        const int cx = index % width;
+        const int cy = index / width;
+        for (int ny = std::max(cy - 1, y0); ny <= std::min(cy + 1, y1 - 1); ++ny) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, width - 1); ++nx) {
+                unsigned char& neighbour = classes[ny * width + nx];
+                if (neighbour == kWeak || neighbour == kStrong) {
+                    neighbour = kEdge;
+                    stack.push_back(ny * width + nx);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void sobel_gradient_scalar(const short* up, const short* mid, const short* down, short* gx, short* gy, int count) {
+    for (int i = 0; i < count; ++i) {
+        gx[i] = static_cast<short>((up[i + 1] - up[i - 1]) + 2 * (mid[i + 1] - mid[i - 1]) + (down[i + 1] - down[i - 1]));
+        gy[i] = static_cast<short>((down[i - 1] + 2 * down[i] + down[i + 1]) - (up[i - 1] + 2 * up[i] + up[i + 1]));
+    }
+}
+
+void sobel_row(const Pixel* const* rows, Pixel* out, int width) {
+    if (width <= 0) {
+        return;
+    }
+    // First and last columns are left unchanged
+    out[0] = rows[1][0];
+    out[width - 1] = rows[1][width - 1];
+
+    const RowKernels& kernels = active_row_kernels();
+    short gray[3][kChunkPixels + 2];
+    short gx[kChunkPixels];
+    short gy[kChunkPixels];
+    for (int x0 = 1; x0 < width - 1; x0 += kChunkPixels) {
+        const int count = std::min(kChunkPixels, width - 1 - x0);
+        for (int k = 0; k < 3; ++k) {
+            gray_sums(rows[k] + x0 - 1, gray[k], count + 2);
+        }
+        kernels.sobel(gray[0] + 1, gray[1] + 1, gray[2] + 1, gx, gy, count);
+        for (int i = 0; i < count; ++i) {
+            const unsigned char value = static_cast<unsigned char>(sobel_magnitude(std::abs(gx[i]) + std::abs(gy[i])));
+            out[x0 + i] = { value, value, value };
+        }
+    }
+}
+
+void sobel_filter(Image& image) {
+    apply_stencil_kernel(image, sobel_row, 1);
+}
+
+Filter make_sobel_filter(Border border) {
+    return make_stencil_filter("sobel", 1, sobel_row, border);
+}
+
+void canny_filter(Image& image, int low, int high, int num_threads) {
+    const int width = image.width();
+    const int height = image.height();
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    // Magnitudes are of gray sums, 3x the gray level
+    const int low3 = 3 * std::max(std::min(low, high), 0);
+    const int high3 = 3 * std::max(std::max(low, high), 0);
+
+    std::vector<unsigned char> classes(static_cast<size_t>(width) * height, kNoEdge);
+    std::vector<char> band_start(height, 0);
+
+    parallel_for(0, height, num_threads, [&](int y0, int y1) {
+        band_start[y0] = 1;
+        CannyBand band(image);
+        for (int y = std::max(y0, 1); y < std::min(y1, height - 1); ++y) {
+            suppress_row(band, y, width, low3, high3, classes.data() + static_cast<size_t>(y) * width);
+        }
+        std::vector<int> stack;
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (classes[static_cast<size_t>(y) * width + x] == kStrong) {
+                    follow_edges(classes.data(), width, y0, y1, x, y, stack);
+                }
+            }
+        }
+    });
+
+    // Weak pixels next to an edge across a band seam were out of reach of
+    // their band; follow them over the whole image
+    std::vector<int> stack;
+    for (int y = 1; y < height; ++y) {
+        if (!band_start[y]) {
+            continue;
+        }
+        for (int side = 0; side < 2; ++side) {
+            const unsigned char* from = classes.data() + static_cast<size_t>(side ? y : y - 1) * width;
+            const int to = side ? y - 1 : y;
+            for (int x = 0; x < width; ++x) {
+                if (from[x] != kEdge) {
+                    continue;
+                }
+                for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx) {
+                    if (classes[static_cast<size_t>(to) * width + nx] == kWeak) {
+                        follow_edges(classes.data(), width, 0, height, nx, to, stack);
+                    }
+                }
+            }
+        }
+    }
+
+    parallel_for(0, height, num_threads, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const unsigned char* row_classes = classes.data() + static_cast<size_t>(y) * width;
+            Pixel* row = image.row(y);
+            for (int x = 0; x < width; ++x) {
+                const unsigned char value = (row_classes[x] == kEdge) ? 255 : 0;
+                row[x] = { value, value, value };
+            }
+        }
+    });
+}
+
+Filter make_canny_filter(int low, int high) {
+    Filter filter([low, high](Image& image) { canny_filter(image, low, high); });
+    filter.name = "canny";
+    return filter;
+}
@@ -0,0 +1,38 @@
+#ifndef _EDGES_H
+#define _EDGES_H
+
+#include "filters.h"
+#include "image.h"
+
+// Edge detection on the gray level (r + g + b) / 3. The gradient is the 3x3
+// Sobel operator, computed on 16-bit rows with the vector version for the
+// current simd_level(); magnitudes are |gx| + |gy|.
+
+// Sobel: gradient magnitude as a gray image, clamped to 255. A stencil of
+// radius 1, so like blur the first and last rows and columns are left
+// unchanged unless a border mode is given, and it streams and fuses in a
+// pipeline.
+void sobel_row(const Pixel* const* rows, Pixel* out, int width);
+void sobel_filter(Image& image);
+
+Filter make_sobel_filter(Border border = {});
+
+// Canny: Sobel gradient, non-maximum suppression along the gradient direction
+// (quantized to 4 sectors) and hysteresis; pixels whose magnitude is above
+// `high`, or above `low` and connected to one that is, become white, all
+// others black. Thresholds are on the same scale as the Sobel output.
+// Pixels outside the image take the value of the nearest edge pixel; the
+// outermost rows and columns are never edges. Usually run after a small
+// Gaussian blur.
+//
+// The rows are split into one band per thread. Each band computes the
+// gradient of its rows plus one halo row on either side, so gradient,
+// suppression and the hysteresis inside the band all happen in a single
+// pass over it; edges that cross from one band into the next are then
+// followed from the band seams.
+void canny_filter(Image& image, int low, int high, int num_threads = 0);
+
+Filter make_canny_filter(int low = 40, int high = 100);
+
+
+#endif // !_EDGES_H
@@ -0,0 +1,529 @@
+#include "filters.h"
+#include "convolution.h"
+#include "filters_simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+Filter::Filter(FilterFunction function)
+    : name("custom"), kind(FilterKind::Image), apply(std::move(function))
+{
+}
+
+Filter::Filter(void (*function)(Image&))
+    : Filter(FilterFunction(function))
+{
+}
+
+Filter make_point_filter(const std::string& name, PointKernel kernel) {
+    Filter filter;
+    filter.name = name;
+    filter.kind = FilterKind::Point;
+    filter.point = kernel;
+    filter.apply = [kernel](Image& image) { apply_point_kernel(image, kernel); };
+    return filter;
+}
+
+Filter make_stencil_filter(const std::string& name, int radius, StencilKernel kernel, Border border) {
+    Filter filter;
+    filter.name = name;
+    filter.kind = FilterKind::Stencil;
+    filter.stencil = kernel;
+    filter.radius = radius;
+    filter.border = border;
+    filter.apply = [kernel, radius, border](Image& image) { apply_stencil_kernel(image, kernel, radius, border); };
+    return filter;
+}
+
+int border_index(int i, int n, BorderMode mode) {
+    if (mode == BorderMode::Wrap) {
+        return ((i % n) + n) % n;
+    }
+    if (mode == BorderMode::Mirror && n > 1) {
+        const int period = 2 * (n - 1);
+        i = ((i % period) + period) % period;
+        return (i < n) ? i : period - i;
+    }
+    return std::clamp(i, 0, n - 1);
+}
+
+Filter make_lut_filter(const std::string& name, const ChannelLut& lut) {
+    auto table = std::make_shared<const ChannelLut>(lut);
+    Filter filter = make_point_filter(name, [table](Pixel* row, int width) { lut_row(row, width, *table); });
+    filter.lut = table;
+    return filter;
+}
+
+// Lookup tables
+ChannelLut ChannelLut::identity() {
+    ChannelLut lut;
+    for (int i = 0; i < 256; ++i) {
+        lut.r[i] = lut.g[i] = lut.b[i] = static_cast<unsigned char>(i);
+    }
+    return lut;
+}
+
+ChannelLut compose(const ChannelLut& first, const ChannelLut& second) {
+    ChannelLut lut;
+    for (int i = 0; i < 256; ++i) {
+        lut.r[i] = second.r[first.r[i]];
+        lut.g[i] = second.g[first.g[i]];
+        lut.b[i] = second.b[first.b[i]];
+    }
+    return lut;
+}
+
+ChannelLut make_channel_lut(const PointKernel& kernel) {
+    // Run the kernel once over a row holding every gray level
+    Image ramp(256, 1);
+    Pixel* row = ramp.row(0);
+    for (int i = 0; i < 256; ++i) {
+        unsigned char level = static_cast<unsigned char>(i);
+        row[i] = { level, level, level };
+    }
+    kernel(row, 256);
+
+    ChannelLut lut;
+    for (int i = 0; i < 256; ++i) {
+        lut.r[i] = row[i].r;
+        lut.g[i] = row[i].g;
+        lut.b[i] = row[i].b;
+    }
+    return lut;
+}
+
+void lut_row(Pixel* row, int width, const ChannelLut& lut) {
+    if (lut.uniform()) {
+        // Channels do not matter: one lookup per byte
+        active_row_kernels().lut_bytes(reinterpret_cast<unsigned char*>(row), 3 * width, lut.r.data());
+        return;
+    }
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        pixel.r = lut.r[pixel.r];
+        pixel.g = lut.g[pixel.g];
+        pixel.b = lut.b[pixel.b];
+    }
+}
+
+void apply_lut(Image& image, const ChannelLut& lut) {
+    for (int i = 0; i < image.height(); ++i) {
+        lut_row(image.row(i), image.width(), lut);
+    }
+}
+
+ChannelLut invert_lut() {
+    return make_channel_lut(invert_row);
+}
+
+ChannelLut brightness_lut(int factor) {
+    return make_channel_lut([factor](Pixel* row, int width) { brightness_row(row, width, factor); });
+}
+
+ChannelLut contrast_lut(float factor, Arithmetic arithmetic) {
+    if (arithmetic == Arithmetic::Reference) {
+        return make_channel_lut([factor](Pixel* row, int width) { contrast_row_reference(row, width, factor); });
+    }
+    return make_channel_lut([factor](Pixel* row, int width) { contrast_row(row, width, factor); });
+}
+
+void lut_bytes_scalar(unsigned char* bytes, int count, const unsigned char* table) {
+    for (int i = 0; i < count; ++i) {
+        bytes[i] = table[bytes[i]];
+    }
+}
+
+// Vectorized kernels
+const RowKernels& scalar_row_kernels() {
+    static constexpr RowKernels kernels = {
+        grayscale_row_scalar, threshold_row_scalar, sepia_row_scalar, saturation_row_scalar,
+        blur_row_scalar, sharpen_row_scalar, sobel_gradient_scalar, lut_bytes_scalar, resample_row_scalar,
+        transpose_tile_scalar, reverse_row_scalar
+    };
+    return kernels;
+}
+
+const RowKernels& row_kernels(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512:
+        return avx512_row_kernels();
+    case SimdLevel::AVX2:
+        return avx2_row_kernels();
+    case SimdLevel::SSE2:
+        return sse2_row_kernels();
+    default:
+        return scalar_row_kernels();
+    }
+}
+
+const RowKernels& active_row_kernels() {
+    return row_kernels(simd_level());
+}
+
+// Stencil window
+StencilWindow::StencilWindow(int width, int radius, Border border, int height)
+    : m_Width(width), m_Height(height), m_Radius(radius),
+      m_Padding(border.mode == BorderMode::None ? 0 : radius), m_Border(border), m_Window(2 * radius + 1)
+{
+    m_Rows = Image(width + 2 * m_Padding, 2 * radius + 1);
+    if (border.mode == BorderMode::Wrap) {
+        m_Outside = Image(width + 2 * m_Padding, 2 * radius);
+    }
+    else if (border.mode == BorderMode::Constant) {
+        m_Outside = Image(width + 2 * m_Padding, 1);
+        std::fill(m_Outside.row(0), m_Outside.row(0) + m_Outside.width(), border.value);
+    }
+}
+
+// Fill the padding of a row (given from pixel -r)
+void StencilWindow::pad(Pixel* row) const {
+    if (m_Padding == 0 || m_Width == 0) {
+        return;
+    }
+    Pixel* pixels = row + m_Padding;
+    for (int x = -m_Padding; x < 0; ++x) {
+        pixels[x] = (m_Border.mode == BorderMode::Constant) ? m_Border.value : pixels[border_index(x, m_Width, m_Border.mode)];
+    }
+    for (int x = m_Width; x < m_Width + m_Padding; ++x) {
+        pixels[x] = (m_Border.mode == BorderMode::Constant) ? m_Border.value : pixels[border_index(x, m_Width, m_Border.mode)];
+    }
+}
+
+void StencilWindow::push(const Pixel* row) {
+    Pixel* slot = m_Rows.row(m_Pushed % m_Rows.height());
+    std::memcpy(slot + m_Padding, row, m_Width * sizeof(Pixel));
+    pad(slot);
+    // The first rows are what the rows below the image wrap around to
+    if (m_Border.mode == BorderMode::Wrap && m_Pushed < m_Radius) {
+        std::memcpy(m_Outside.row(m_Radius + m_Pushed), slot, m_Rows.width() * sizeof(Pixel));
+    }
+    ++m_Pushed;
+}
+
+void StencilWindow::push_wrapped(const Pixel* row) {
+    Pixel* slot = m_Outside.row(m_Wrapped++);
+    std::memcpy(slot + m_Padding, row, m_Width * sizeof(Pixel));
+    pad(slot);
+}
+
+// Row y from pixel -padding; rows outside the image follow the border mode
+const Pixel* StencilWindow::resolve(int y) const {
+    if (m_Padding == 0 || (y >= 0 && y < m_Height)) {
+        return m_Rows.row(y % m_Rows.height());
+    }
+    switch (m_Border.mode) {
+    case BorderMode::Constant:
+        return m_Outside.row(0);
+    case BorderMode::Wrap:
+        return (y < 0) ? m_Outside.row(y + m_Radius) : m_Outside.row(m_Radius + border_index(y, m_Height, BorderMode::Wrap));
+    default:
+        // Clamp and Mirror read rows within r of the edge, still in the window
+        return m_Rows.row(border_index(y, m_Height, m_Border.mode) % m_Rows.height());
+    }
+}
+
+const Pixel* const* StencilWindow::rows_around(int y) {
+    for (int k = 0; k <= 2 * m_Radius; ++k) {
+        m_Window[k] = resolve(y - m_Radius + k);
+    }
+    return m_Window.data();
+}
+
+void apply_point_kernel(Image& image, const PointKernel& kernel) {
+    for (int i = 0; i < image.height(); ++i) {
+        kernel(image.row(i), image.width());
+    }
+}
+
+void apply_stencil_kernel(Image& image, const StencilKernel& kernel, int radius, const Border& border) {
+    int height = image.height();
+    if (border.mode != BorderMode::None) {
+        const int width = image.width();
+        if (width <= 0 || height <= 0) {
+            return;
+        }
+        StencilWindow window(width, radius, border, height);
+        if (border.mode == BorderMode::Wrap) {
+            for (int y = -radius; y < 0; ++y) {
+                window.push_wrapped(image.row(border_index(y, height, BorderMode::Wrap)));
+            }
+        }
+        for (int i = 0; i < std::min(radius, height); ++i) {
+            window.push(image.row(i));
+        }
+
+        // Interior and borders alike run the kernel over padded rows
+        Image out(width + 2 * radius, 1);
+        for (int i = 0; i < height; ++i) {
+            if (i + radius < height) {
+                window.push(image.row(i + radius));
+            }
+            kernel(window.rows_around(i), out.row(0), out.width());
+            std::memcpy(image.row(i), out.row(0) + radius, width * sizeof(Pixel));
+        }
+        return;
+    }
+
+    if (height <= 2 * radius) {
+        return;
+    }
+
+    // Rows 0 .. 2r - 1 are needed before the first output row
+    StencilWindow window(image.width(), radius);
+    for (int i = 0; i < 2 * radius; ++i) {
+        window.push(image.row(i));
+    }
+
+    for (int i = radius; i < height - radius; ++i) {
+        // Row i + r is still original: only rows < i have been written
+        window.push(image.row(i + radius));
+        kernel(window.rows_around(i), image.row(i), image.width());
+    }
+}
+
+// Grayscale Filter
+void grayscale_row_scalar(Pixel* row, int width) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        unsigned char gray = (pixel.r + pixel.g + pixel.b) / 3;
+        pixel.r = gray;
+        pixel.g = gray;
+        pixel.b = gray;
+    }
+}
+
+// Invert Filter
+void invert_row(Pixel* row, int width) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        pixel.r = 255 - pixel.r;
+        pixel.g = 255 - pixel.g;
+        pixel.b = 255 - pixel.b;
+    }
+}
+
+// Brightness Adjust Filter (scales brightness by a factor)
+void brightness_row(Pixel* row, int width, int factor) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        pixel.r = std::min(255, pixel.r + factor);
+        pixel.g = std::min(255, pixel.g + factor);
+        pixel.b = std::min(255, pixel.b + factor);
+    }
+}
+
+namespace {
+
+// Largest contrast factor: 128 * 255 * 65536 still fits an int
+constexpr float kMaxContrast = 255.0f;
+
+// Contrast factor in 16.16 fixed point
+int contrast_scale(float factor) {
+    return static_cast<int>(std::lround(std::clamp(factor, -kMaxContrast, kMaxContrast) * 65536.0f));
+}
+
+inline unsigned char contrast_channel(int value, int scale) {
+    // >> rounds down like the int conversion of the (non-negative) float result
+    return static_cast<unsigned char>(std::clamp(128 + (((value - 128) * scale) >> 16), 0, 255));
+}
+
+} // namespace
+
+// Contrast Adjust Filter (simple contrast stretch)
+void contrast_row(Pixel* row, int width, float factor) {
+    const int scale = contrast_scale(factor);
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        pixel.r = contrast_channel(pixel.r, scale);
+        pixel.g = contrast_channel(pixel.g, scale);
+        pixel.b = contrast_channel(pixel.b, scale);
+    }
+}
+
+void contrast_row_reference(Pixel* row, int width, float factor) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        pixel.r = std::clamp(int(((pixel.r - 128) * factor) + 128), 0, 255);
+        pixel.g = std::clamp(int(((pixel.g - 128) * factor) + 128), 0, 255);
+        pixel.b = std::clamp(int(((pixel.b - 128) * factor) + 128), 0, 255);
+    }
+}
+
+// Threshold Filter
+void threshold_row_scalar(Pixel* row, int width, unsigned char threshold) {
+    // (r + g + b) / 3 > threshold  <=>  r + g + b > 3 * threshold + 2,
+    // so the division and the branch can go
+    const int limit = 3 * threshold + 2;
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        unsigned char value = (pixel.r + pixel.g + pixel.b > limit) ? 255 : 0;
+        pixel.r = pixel.g = pixel.b = value;
+    }
+}
+
+// Blur Filter (simple average blur), radius 1
+void blur_row_scalar(const Pixel* const* rows, Pixel* out, int width) {
+    convolve_row<kBlur3x3>(rows, out, width);
+}
+
+// Sharpen Filter (simple edge sharpen), radius 1
+void sharpen_row_scalar(const Pixel* const* rows, Pixel* out, int width) {
+    convolve_row<kSharpen3x3>(rows, out, width);
+}
+
+// Sepia Tone Filter
+namespace {
+
+inline unsigned char sepia_channel(const int* w, int r, int g, int b) {
+    const int sum = ((r * w[0]) >> 8) + ((g * w[1]) >> 8) + ((b * w[2]) >> 8);
+    return static_cast<unsigned char>(std::min(255, (sum + kSepiaBias) >> 7));
+}
+
+} // namespace
+
+void sepia_row_scalar(Pixel* row, int width) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        const int r = pixel.r;
+        const int g = pixel.g;
+        const int b = pixel.b;
+        pixel.r = sepia_channel(kSepiaWeights[0], r, g, b);
+        pixel.g = sepia_channel(kSepiaWeights[1], r, g, b);
+        pixel.b = sepia_channel(kSepiaWeights[2], r, g, b);
+    }
+}
+
+void sepia_row_reference(Pixel* row, int width) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        unsigned char r = pixel.r;
+        unsigned char g = pixel.g;
+        unsigned char b = pixel.b;
+
+        pixel.r = std::min(255, (int)(0.393 * r + 0.769 * g + 0.189 * b));
+        pixel.g = std::min(255, (int)(0.349 * r + 0.686 * g + 0.168 * b));
+        pixel.b = std::min(255, (int)(0.272 * r + 0.534 * g + 0.131 * b));
+    }
+}
+
+// Saturation Adjust Filter
+void saturation_row_scalar(Pixel* row, int width, int scale) {
+    for (int j = 0; j < width; ++j) {
+        Pixel& pixel = row[j];
+        // BT.601 luma in 8.8 fixed point (the weights add up to 256)
+        const int gray = (77 * pixel.r + 150 * pixel.g + 29 * pixel.b + 128) >> 8;
+        pixel.r = static_cast<unsigned char>(std::clamp(gray + (((pixel.r - gray) * scale) >> 8), 0, 255));
+        pixel.g = static_cast<unsigned char>(std::clamp(gray + (((pixel.g - gray) * scale) >> 8), 0, 255));
+        pixel.b = static_cast<unsigned char>(std::clamp(gray + (((pixel.b - gray) * scale) >> 8), 0, 255));
+    }
+}
+
+namespace {
+
+// Saturation factor in 8.8 fixed point
+int saturation_scale(float factor) {
+    return static_cast<int>(std::clamp(factor * 256.0f + 0.5f, 0.0f, static_cast<float>(kMaxSaturationScale)));
+}
+
+} // namespace
+
+// Row kernels at the current SIMD level
+void grayscale_row(Pixel* row, int width) {
+    active_row_kernels().grayscale(row, width);
+}
+
+void threshold_row(Pixel* row, int width, unsigned char threshold) {
+    active_row_kernels().threshold(row, width, threshold);
+}
+
+void blur_row(const Pixel* const* rows, Pixel* out, int width) {
+    active_row_kernels().blur(rows, out, width);
+}
+
+void sharpen_row(const Pixel* const* rows, Pixel* out, int width) {
+    active_row_kernels().sharpen(rows, out, width);
+}
+
+void sepia_row(Pixel* row, int width) {
+    active_row_kernels().sepia(row, width);
+}
+
+void saturation_row(Pixel* row, int width, float factor) {
+    active_row_kernels().saturation(row, width, saturation_scale(factor));
+}
+
+void grayscale_filter(Image& image) {
+    apply_point_kernel(image, grayscale_row);
+}
+
+void invert_filter(Image& image) {
+    apply_lut(image, invert_lut());
+}
+
+void brightness_filter(Image& image, int factor) {
+    apply_lut(image, brightness_lut(factor));
+}
+
+void contrast_filter(Image& image, float factor, Arithmetic arithmetic) {
+    apply_lut(image, contrast_lut(factor, arithmetic));
+}
+
+void threshold_filter(Image& image, unsigned char threshold) {
+    apply_point_kernel(image, [threshold](Pixel* row, int width) { threshold_row(row, width, threshold); });
+}
+
+void blur_filter(Image& image) {
+    apply_stencil_kernel(image, blur_row, 1);
+}
+
+void sharpen_filter(Image& image) {
+    apply_stencil_kernel(image, sharpen_row, 1);
+}
+
+void sepia_filter(Image& image, Arithmetic arithmetic) {
+    apply_point_kernel(image, (arithmetic == Arithmetic::Reference) ? sepia_row_reference : sepia_row);
+}
+
+void saturation_filter(Image& image, float factor) {
+    const int scale = saturation_scale(factor);
+    apply_point_kernel(image, [scale](Pixel* row, int width) { active_row_kernels().saturation(row, width, scale); });
+}
+
+Filter make_grayscale_filter() {
+    return make_point_filter("grayscale", grayscale_row);
+}
+
+Filter make_invert_filter() {
+    return make_lut_filter("invert", invert_lut());
+}
+
+Filter make_brightness_filter(int factor) {
+    return make_lut_filter("brightness", brightness_lut(factor));
+}
+
+Filter make_contrast_filter(float factor, Arithmetic arithmetic) {
+    return make_lut_filter("contrast", contrast_lut(factor, arithmetic));
+}
+
+Filter make_threshold_filter(unsigned char threshold) {
+    return make_point_filter("threshold", [threshold](Pixel* row, int width) { threshold_row(row, width, threshold); });
+}
+
+Filter make_blur_filter(Border border) {
+    return make_stencil_filter("blur", 1, blur_row, border);
+}
+
+Filter make_sharpen_filter(Border border) {
+    return make_stencil_filter("sharpen", 1, sharpen_row, border);
+}
+
+Filter make_sepia_filter(Arithmetic arithmetic) {
+    return make_point_filter("sepia", (arithmetic == Arithmetic::Reference) ? sepia_row_reference : sepia_row);
+}
+
+Filter make_saturation_filter(float factor) {
+    const int scale = saturation_scale(factor);
+    return make_point_filter("saturation", [scale](Pixel* row, int width) { active_row_kernels().saturation(row, width, scale); });
+}
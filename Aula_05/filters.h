@@ -0,0 +1,211 @@
+#ifndef _FILTERS_H
+#define _FILTERS_H
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image.h"
+
+// Filter function type for flexibility in the pipeline
+typedef std::function<void(Image&)> FilterFunction;
+
+// Row kernels
+//
+// PointKernel: per-pixel filter, applied in place to `width` pixels of one row.
+// StencilKernel: neighbourhood filter with a vertical radius r. `rows` holds
+// the 2r + 1 input rows centred on the output row (rows[r] is the centre);
+// the result for the whole row is written to `out`.
+typedef std::function<void(Pixel* row, int width)> PointKernel;
+typedef std::function<void(const Pixel* const* rows, Pixel* out, int width)> StencilKernel;
+
+// Per-channel lookup table for 8-bit point filters:
+// out.r = r[in.r], out.g = g[in.g], out.b = b[in.b]
+struct ChannelLut {
+    std::array<unsigned char, 256> r;
+    std::array<unsigned char, 256> g;
+    std::array<unsigned char, 256> b;
+
+    static ChannelLut identity();
+    // Same table for all three channels (can be applied byte by byte)
+    bool uniform() const { return r == g && g == b; }
+};
+
+// Table of `second` applied after `first`
+ChannelLut compose(const ChannelLut& first, const ChannelLut& second);
+
+// Tabulate a point kernel over the 256 gray levels. Only valid for kernels
+// that treat each channel on its own (out.r depends on in.r only, etc.).
+ChannelLut make_channel_lut(const PointKernel& kernel);
+
+// How a stencil reads the pixels past the edges of the image
+enum class BorderMode {
+    None,     // rows and columns closer than r to the edge are left unchanged
+    Clamp,    // the nearest edge pixel
+    Mirror,   // reflected about the edge pixel: -1 reads 1, n reads n - 2
+    Wrap,     // from the opposite edge (needs the whole image, cannot be streamed)
+    Constant  // Border::value
+};
+
+struct Border {
+    BorderMode mode = BorderMode::None;
+    Pixel value = { 0, 0, 0 };
+};
+
+// Index in [0, n) that position i reads under Clamp, Mirror or Wrap
+int border_index(int i, int n, BorderMode mode);
+
+enum class FilterKind {
+    Point,   // output pixel depends only on the same input pixel
+    Stencil, // output pixel depends on a (2r + 1) x (2r + 1) neighbourhood
+    Image    // needs the whole image (cannot be streamed)
+};
+
+// One pipeline stage. Point and stencil filters expose their row kernel so
+// the pipeline can stream, fuse or tile them; `apply` always runs the filter
+// on a whole image.
+struct Filter {
+    std::string name;
+    FilterKind kind = FilterKind::Image;
+    PointKernel point;
+    StencilKernel stencil;
+    int radius = 0;
+    Border border; // stencil filters only
+    std::shared_ptr<const ChannelLut> lut; // set when the point filter is a table lookup
+    FilterFunction apply;
+
+    Filter() = default;
+    // Any Image& function can still be used as an (opaque) pipeline stage
+    Filter(FilterFunction function);
+    Filter(void (*function)(Image&));
+};
+
+Filter make_point_filter(const std::string& name, PointKernel kernel);
+Filter make_stencil_filter(const std::string& name, int radius, StencilKernel kernel, Border border = {});
+// Point filter that is a single table lookup per byte. Consecutive LUT
+// filters are composed into one table by the pipeline.
+Filter make_lut_filter(const std::string& name, const ChannelLut& lut);
+
+// Class StencilWindow
+//
+// Rolling window over the last 2r + 1 rows fed to a stencil: rows are copied
+// in one by one with push(), and rows_around(y) returns the 2r + 1 row
+// pointers a StencilKernel needs for output row y (requires rows y - r .. y + r
+// to be the most recent ones pushed). Memory is O(width * (2r + 1)).
+//
+// With a border mode other than None this is also where the border is made,
+// so the kernels only ever see interior pixels: every row is stored with r
+// pixels of padding on either side, filled by the border rule as it is
+// pushed, and rows_around(y) maps the rows above and below the image (given
+// its height) onto the rows they read. The pointers then start at pixel -r
+// and the kernel runs over width + 2r pixels; its output for pixel x is at
+// x + r. Wrap reads rows from the far end: pass the r rows that wrap around
+// to the top to push_wrapped() before the first push().
+
+class StencilWindow
+{
+public:
+    StencilWindow(int width, int radius, Border border = {}, int height = 0);
+
+    void push(const Pixel* row);
+    void push_wrapped(const Pixel* row);
+    int pushed() const { return m_Pushed; }
+    int radius() const { return m_Radius; }
+    // Pixels of padding on either side of a row (r, or 0 for BorderMode::None)
+    int padding() const { return m_Padding; }
+
+    const Pixel* const* rows_around(int y);
+    const Pixel* row(int y) const { return m_Rows.row(y % m_Rows.height()) + m_Padding; }
+
+private:
+    void pad(Pixel* row) const;
+    const Pixel* resolve(int y) const;
+
+    Image m_Rows;
+    int m_Width;
+    int m_Height;
+    int m_Radius;
+    int m_Padding;
+    Border m_Border;
+    int m_Pushed = 0;
+    int m_Wrapped = 0;
+    // Wrap: rows -r .. -1, then copies of rows 0 .. r - 1; Constant: one row of the value
+    Image m_Outside;
+    std::vector<const Pixel*> m_Window;
+};
+
+// Run a point kernel over every row of the image
+void apply_point_kernel(Image& image, const PointKernel& kernel);
+
+// Run a stencil kernel in place. Only a rolling window of 2r + 1 original rows
+// is kept instead of a copy of the whole image. With BorderMode::None, rows
+// closer than r to the top or bottom are left unchanged.
+void apply_stencil_kernel(Image& image, const StencilKernel& kernel, int radius, const Border& border = {});
+
+// Apply a lookup table to one row / to a whole image
+void lut_row(Pixel* row, int width, const ChannelLut& lut);
+void apply_lut(Image& image, const ChannelLut& lut);
+
+// Integer arithmetic of the colour filters. Sepia and contrast run in fixed
+// point by default; Reference selects their original floating-point
+// formulas, kept to check the fixed-point results against (they differ by
+// at most 1 per channel).
+enum class Arithmetic {
+    Fixed,
+    Reference
+};
+
+// Tables of the per-channel filters (identical results to their row kernels)
+ChannelLut invert_lut();
+ChannelLut brightness_lut(int factor);
+ChannelLut contrast_lut(float factor, Arithmetic arithmetic = Arithmetic::Fixed);
+
+// Row kernels of the filters below. Grayscale, threshold, blur, sharpen,
+// sepia and saturation use the vector version for the current simd_level()
+// (cpu_features.h).
+void grayscale_row(Pixel* row, int width);
+void invert_row(Pixel* row, int width);
+void brightness_row(Pixel* row, int width, int factor);
+// Contrast: 128 + (c - 128) * factor, with factor in 16.16 fixed point
+// (clamped to [-255, 255], past which the output no longer changes)
+void contrast_row(Pixel* row, int width, float factor);
+void threshold_row(Pixel* row, int width, unsigned char threshold);
+void blur_row(const Pixel* const* rows, Pixel* out, int width);
+void sharpen_row(const Pixel* const* rows, Pixel* out, int width);
+// Sepia: weights in Q15, see kSepiaWeights in filters_simd.h
+void sepia_row(Pixel* row, int width);
+// Saturation: every channel is moved away from (factor > 1) or towards
+// (factor < 1) the luma 0.299 r + 0.587 g + 0.114 b of its pixel, so 0 gives
+// gray and 1 the input. Done as a blend in 8.8 fixed point instead of an HSV
+// round trip; factor is clamped to [0, 8).
+void saturation_row(Pixel* row, int width, float factor);
+// Floating-point versions of sepia and contrast (Arithmetic::Reference)
+void contrast_row_reference(Pixel* row, int width, float factor);
+void sepia_row_reference(Pixel* row, int width);
+
+// Whole-image filters
+void grayscale_filter(Image& image);
+void invert_filter(Image& image);
+void brightness_filter(Image& image, int factor);
+void contrast_filter(Image& image, float factor, Arithmetic arithmetic = Arithmetic::Fixed);
+void threshold_filter(Image& image, unsigned char threshold);
+void blur_filter(Image& image);
+void sharpen_filter(Image& image);
+void sepia_filter(Image& image, Arithmetic arithmetic = Arithmetic::Fixed);
+void saturation_filter(Image& image, float factor);
+
+// Pipeline stages
+Filter make_grayscale_filter();
+Filter make_invert_filter();
+Filter make_brightness_filter(int factor);
+Filter make_contrast_filter(float factor, Arithmetic arithmetic = Arithmetic::Fixed);
+Filter make_threshold_filter(unsigned char threshold);
+Filter make_blur_filter(Border border = {});
+Filter make_sharpen_filter(Border border = {});
+Filter make_sepia_filter(Arithmetic arithmetic = Arithmetic::Fixed);
+Filter make_saturation_filter(float factor);
+
+
+#endif // !_FILTERS_H
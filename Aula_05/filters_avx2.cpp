@@ -0,0 +1,77 @@
+#include "filters_simd.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <initializer_list>
+
+#include <immintrin.h>
+
+// Only this file is compiled for AVX2; its kernels run only after
+// detect_simd_level() has found AVX2 on the CPU
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+namespace {
+
+struct Avx2 {
+    typedef __m256i V;
+    static constexpr int kBytes = 32;
+    static constexpr bool kHasShuffle = true;
+
+    static V load(const unsigned char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(unsigned char* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V zero() { return _mm256_setzero_si256(); }
+    static V set1_8(int x) { return _mm256_set1_epi8(static_cast<char>(x)); }
+    static V set1_16(int x) { return _mm256_set1_epi16(static_cast<short>(x)); }
+
+    static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+    static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+    static V add8(V a, V b) { return _mm256_add_epi8(a, b); }
+    static V sub8(V a, V b) { return _mm256_sub_epi8(a, b); }
+    static V adds_u8(V a, V b) { return _mm256_adds_epu8(a, b); }
+    static V add16(V a, V b) { return _mm256_add_epi16(a, b); }
+    static V sub16(V a, V b) { return _mm256_sub_epi16(a, b); }
+    static V mullo16(V a, V b) { return _mm256_mullo_epi16(a, b); }
+    static V mulhi_u16(V a, V b) { return _mm256_mulhi_epu16(a, b); }
+    static V mulhi_i16(V a, V b) { return _mm256_mulhi_epi16(a, b); }
+    static V cmpgt16(V a, V b) { return _mm256_cmpgt_epi16(a, b); }
+    // Unpack and pack work per 128-bit lane, so unpack + pack keeps the byte order
+    static V unpacklo8(V a, V b) { return _mm256_unpacklo_epi8(a, b); }
+    static V unpackhi8(V a, V b) { return _mm256_unpackhi_epi8(a, b); }
+    static V packus16(V a, V b) { return _mm256_packus_epi16(a, b); }
+    static V packs16(V a, V b) { return _mm256_packs_epi16(a, b); }
+    static V set1_32(int x) { return _mm256_set1_epi32(x); }
+    static V add32(V a, V b) { return _mm256_add_epi32(a, b); }
+    template <int Shift>
+    static V srai32(V a) { return _mm256_srai_epi32(a, Shift); }
+    static V madd16(V a, V b) { return _mm256_madd_epi16(a, b); }
+    static V packs32(V a, V b) { return _mm256_packs_epi32(a, b); }
+    static V broadcast_16(const unsigned char* p) {
+        return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static V shuffle8(V table, V index) { return _mm256_shuffle_epi8(table, index); }
+    static __m128i shuffle8_128(__m128i table, __m128i index) { return _mm_shuffle_epi8(table, index); }
+};
+
+} // namespace
+
+#include "filters_simd_kernels.h"
+
+const RowKernels& avx2_row_kernels() {
+    return SimdKernels<Avx2>::table();
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+const RowKernels& avx2_row_kernels() {
+    return scalar_row_kernels();
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef _FILTERS_SIMD_H
+#define _FILTERS_SIMD_H
+
+#include <cstddef>
+
+#include "cpu_features.h"
+#include "image.h"
+
+// Internal to the filters: the row kernels that have vectorized versions,
+// one table per instruction set. filters.cpp dispatches the public row
+// kernels through active_row_kernels(); every version gives byte-identical
+// results to the scalar one.
+//
+// Invert, brightness and contrast run as 256-entry tables (see ChannelLut),
+// so their vector version is lut_bytes. The floating-point reference
+// kernels (Arithmetic::Reference) are scalar only.
+
+// 16 * scale has to fit a signed 16-bit lane
+constexpr int kMaxSaturationScale = 2047;
+
+// Sepia weights in Q15, round(w * 32768), one row per output channel.
+// A channel is ((r * w0) >> 8) + ((g * w1) >> 8) + ((b * w2) >> 8) in Q7,
+// which stays below 2^16, then (sum + kSepiaBias) >> 7 saturated to 255.
+// The bias makes up for the three truncations: 0.26% of the results are
+// 1 away from the floating-point formula, none further.
+constexpr int kSepiaWeights[3][3] = {
+    { 12878, 25199, 6193 }, // 0.393, 0.769, 0.189
+    { 11436, 22479, 5505 }, // 0.349, 0.686, 0.168
+    { 8913, 17498, 4293 },  // 0.272, 0.534, 0.131
+};
+constexpr int kSepiaBias = 1;
+
+// Resampling weights (resize.cpp) are in Q14: a row of weights adds up to
+// 1 << kResampleBits
+constexpr int kResampleBits = 14;
+
+struct RowKernels {
+    void (*grayscale)(Pixel* row, int width);
+    void (*threshold)(Pixel* row, int width, unsigned char threshold);
+    void (*sepia)(Pixel* row, int width);
+    // scale: saturation factor in 8.8 fixed point, 0 .. kMaxSaturationScale
+    void (*saturation)(Pixel* row, int width, int scale);
+    void (*blur)(const Pixel* const* rows, Pixel* out, int width);
+    void (*sharpen)(const Pixel* const* rows, Pixel* out, int width);
+    // Sobel gradients of planar 16-bit rows for i in [0, count); reads
+    // up, mid and down at i - 1 .. i + 1
+    void (*sobel)(const short* up, const short* mid, const short* down, short* gx, short* gy, int count);
+    // bytes[i] = table[bytes[i]] for `count` bytes
+    void (*lut_bytes)(unsigned char* bytes, int count, const unsigned char* table);
+    // out[i] = (sum of weights[k] * rows[k][i] over k < taps, rounded) >> kResampleBits,
+    // saturated to 0 .. 255, for i in [0, count); taps is even
+    void (*resample)(const unsigned char* const* rows, const short* weights, int taps, unsigned char* out, int count);
+    // Transpose of a width x height tile: the pixel at src + y * src_stride + 3 x
+    // goes to dst + x * dst_stride + 3 y. Strides may be negative (flipped rows).
+    void (*transpose)(const unsigned char* src, std::ptrdiff_t src_stride, unsigned char* dst, std::ptrdiff_t dst_stride,
+                      int width, int height);
+    // out[i] = in[width - 1 - i]; in and out do not overlap
+    void (*reverse)(const Pixel* in, Pixel* out, int width);
+};
+
+const RowKernels& scalar_row_kernels();
+const RowKernels& sse2_row_kernels();   // filters_sse2.cpp
+const RowKernels& avx2_row_kernels();   // filters_avx2.cpp
+const RowKernels& avx512_row_kernels(); // filters_avx512.cpp
+
+const RowKernels& row_kernels(SimdLevel level);
+// Kernels for the current simd_level()
+const RowKernels& active_row_kernels();
+
+// Scalar kernels, also used by the vector versions for the pixels at the
+// ends of a row that do not fill a whole vector
+void grayscale_row_scalar(Pixel* row, int width);
+void threshold_row_scalar(Pixel* row, int width, unsigned char threshold);
+void sepia_row_scalar(Pixel* row, int width);
+void saturation_row_scalar(Pixel* row, int width, int scale);
+void blur_row_scalar(const Pixel* const* rows, Pixel* out, int width);
+void sharpen_row_scalar(const Pixel* const* rows, Pixel* out, int width);
+void sobel_gradient_scalar(const short* up, const short* mid, const short* down, short* gx, short* gy, int count); // edges.cpp
+void lut_bytes_scalar(unsigned char* bytes, int count, const unsigned char* table);
+void resample_row_scalar(const unsigned char* const* rows, const short* weights, int taps, unsigned char* out, int count); // resize.cpp
+void transpose_tile_scalar(const unsigned char* src, std::ptrdiff_t src_stride, unsigned char* dst, std::ptrdiff_t dst_stride,
+                           int width, int height); // geometry.cpp
+void reverse_row_scalar(const Pixel* in, Pixel* out, int width); // geometry.cpp
+
+
+#endif // !_FILTERS_SIMD_H
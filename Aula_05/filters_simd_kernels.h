@@ -0,0 +1,474 @@
+#ifndef _FILTERS_SIMD_KERNELS_H
+#define _FILTERS_SIMD_KERNELS_H
+
+#include <cstring>
+
+#include "filters_simd.h"
+
+// Vectorized row kernels, written once against a small wrapper `Isa` around
+// the intrinsics of one instruction set. Each filters_<isa>.cpp defines its
+// wrapper and includes this file after telling the compiler to target that
+// instruction set; nothing here is compiled on its own.
+//
+// Isa provides V (integer vector of kBytes bytes), load / store, zero,
+// set1_8 / set1_16, and_ / or_, add8 / sub8 / adds_u8, add16 / sub16 /
+// mullo16 / mulhi_u16 / mulhi_i16 / cmpgt16, unpacklo8 / unpackhi8,
+// packus16 / packs16, and for 32-bit lanes set1_32 / add32 / srai32<Shift>,
+// madd16 (pmaddwd) and packs32. With kHasShuffle it also has broadcast_16,
+// shuffle8 (pshufb) and shuffle8_128, pshufb on one 128-bit vector: the
+// geometry kernels move whole pixels in 128-bit vectors with SSE2
+// intrinsics whatever the width of V.
+//
+// Pixels stay interleaved. A block of N pixels is 3 vectors; in each byte
+// the pixel's own r, g and b are picked out of loads shifted by -2 .. +2
+// bytes with the masks of the byte's phase (offset % 3), so the channel
+// maths runs on every byte at once and no shuffle is needed.
+
+namespace {
+
+constexpr int kMaxBlockBytes = 3 * 64;
+
+struct PhaseTables {
+    alignas(64) unsigned char mask[3][kMaxBlockBytes];
+    // Low and high byte of the sepia weight of input channel k for the
+    // output channel of each byte; unpacked together they give the 16-bit
+    // weights in the lane order of the unpacked pixels
+    alignas(64) unsigned char sepia_lo[3][kMaxBlockBytes];
+    alignas(64) unsigned char sepia_hi[3][kMaxBlockBytes];
+};
+
+constexpr PhaseTables make_phase_tables() {
+    PhaseTables tables{};
+    for (int i = 0; i < kMaxBlockBytes; ++i) {
+        int phase = i % 3;
+        for (int k = 0; k < 3; ++k) {
+            tables.mask[k][i] = (k == phase) ? 0xFF : 0x00;
+        }
+        for (int k = 0; k < 3; ++k) {
+            tables.sepia_lo[k][i] = static_cast<unsigned char>(kSepiaWeights[phase][k] & 0xFF);
+            tables.sepia_hi[k][i] = static_cast<unsigned char>(kSepiaWeights[phase][k] >> 8);
+        }
+    }
+    return tables;
+}
+
+constexpr PhaseTables kPhase = make_phase_tables();
+
+// Pixels 0 .. 3 at p (12 bytes) in bytes 0 .. 11, without reading past them
+inline __m128i load_4_pixels(const unsigned char* p) {
+    int last;
+    std::memcpy(&last, p + 8, 4);
+    return _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_cvtsi32_si128(last));
+}
+
+inline void store_4_pixels(unsigned char* p, __m128i v) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), v);
+    const int last = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+    std::memcpy(p + 8, &last, 4);
+}
+
+template <typename Isa>
+struct SimdKernels
+{
+    typedef typename Isa::V V;
+    static constexpr int N = Isa::kBytes;
+    static constexpr int kBlock = 3 * N; // bytes of a block of N pixels
+
+    // r, g and b of the pixel each byte of p[0 .. N) belongs to; p is part
+    // `part` (0..2) of a block that starts on a pixel boundary
+    static void channels(const unsigned char* p, int part, V& r, V& g, V& b) {
+        const V m0 = Isa::load(kPhase.mask[0] + part * N);
+        const V m1 = Isa::load(kPhase.mask[1] + part * N);
+        const V m2 = Isa::load(kPhase.mask[2] + part * N);
+        const V before2 = Isa::load(p - 2);
+        const V before1 = Isa::load(p - 1);
+        const V here = Isa::load(p);
+        const V after1 = Isa::load(p + 1);
+        const V after2 = Isa::load(p + 2);
+        r = Isa::or_(Isa::or_(Isa::and_(m0, here), Isa::and_(m1, before1)), Isa::and_(m2, before2));
+        g = Isa::or_(Isa::or_(Isa::and_(m0, after1), Isa::and_(m1, here)), Isa::and_(m2, before1));
+        b = Isa::or_(Isa::or_(Isa::and_(m0, after2), Isa::and_(m1, after1)), Isa::and_(m2, here));
+    }
+
+    // r + g + b per byte, as 16-bit lanes (low and high half of the vector)
+    static void channel_sums(const unsigned char* p, int part, V& lo, V& hi) {
+        V r, g, b;
+        channels(p, part, r, g, b);
+        const V zero = Isa::zero();
+        lo = Isa::add16(Isa::add16(Isa::unpacklo8(r, zero), Isa::unpacklo8(g, zero)), Isa::unpacklo8(b, zero));
+        hi = Isa::add16(Isa::add16(Isa::unpackhi8(r, zero), Isa::unpackhi8(g, zero)), Isa::unpackhi8(b, zero));
+    }
+
+    // Point kernels run in place, block by block, on pixels 1 .. width - 2 at
+    // most. A block reads 2 bytes on either side, so pixel 0 and the pixels
+    // after the last whole block are left to the scalar kernel; all loads of
+    // a block happen before its stores.
+    static bool fits_block(int x, int width) { return x + N <= width - 1; }
+
+    static void grayscale(Pixel* row, int width) {
+        if (width <= 0) {
+            return;
+        }
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(row);
+        const V third = Isa::set1_16(21846); // (s * 21846) >> 16 == s / 3 for s <= 765
+        int x = 1;
+        for (; fits_block(x, width); x += N) {
+            unsigned char* p = bytes + 3 * x;
+            V out[3];
+            for (int part = 0; part < 3; ++part) {
+                V lo, hi;
+                channel_sums(p + part * N, part, lo, hi);
+                out[part] = Isa::packus16(Isa::mulhi_u16(lo, third), Isa::mulhi_u16(hi, third));
+            }
+            for (int part = 0; part < 3; ++part) {
+                Isa::store(p + part * N, out[part]);
+            }
+        }
+        grayscale_row_scalar(row, 1);
+        grayscale_row_scalar(row + x, width - x);
+    }
+
+    static void threshold(Pixel* row, int width, unsigned char threshold) {
+        if (width <= 0) {
+            return;
+        }
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(row);
+        const V limit = Isa::set1_16(3 * threshold + 2);
+        int x = 1;
+        for (; fits_block(x, width); x += N) {
+            unsigned char* p = bytes + 3 * x;
+            V out[3];
+            for (int part = 0; part < 3; ++part) {
+                V lo, hi;
+                channel_sums(p + part * N, part, lo, hi);
+                // 0xFFFF / 0 per lane, packed to 0xFF / 0
+                out[part] = Isa::packs16(Isa::cmpgt16(lo, limit), Isa::cmpgt16(hi, limit));
+            }
+            for (int part = 0; part < 3; ++part) {
+                Isa::store(p + part * N, out[part]);
+            }
+        }
+        threshold_row_scalar(row, 1, threshold);
+        threshold_row_scalar(row + x, width - x, threshold);
+    }
+
+    // One half of the bytes, as 16-bit lanes holding c << 8: a mulhi by the
+    // Q15 weight is (c * w) >> 8 and the final mulhi by 512 is >> 7, so the
+    // lanes go through exactly the integer steps of sepia_row_scalar
+    static V sepia_half(V r, V g, V b, const V* weights) {
+        const V sum = Isa::add16(Isa::add16(Isa::mulhi_u16(r, weights[0]), Isa::mulhi_u16(g, weights[1])),
+                                 Isa::add16(Isa::mulhi_u16(b, weights[2]), Isa::set1_16(kSepiaBias)));
+        return Isa::mulhi_u16(sum, Isa::set1_16(512));
+    }
+
+    static void sepia(Pixel* row, int width) {
+        if (width <= 0) {
+            return;
+        }
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(row);
+        const V zero = Isa::zero();
+        // Weights of the input r, g and b per part of a block and half of a vector
+        V weights[3][2][3];
+        for (int part = 0; part < 3; ++part) {
+            for (int k = 0; k < 3; ++k) {
+                const V lo = Isa::load(kPhase.sepia_lo[k] + part * N);
+                const V hi = Isa::load(kPhase.sepia_hi[k] + part * N);
+                weights[part][0][k] = Isa::unpacklo8(lo, hi);
+                weights[part][1][k] = Isa::unpackhi8(lo, hi);
+            }
+        }
+        int x = 1;
+        for (; fits_block(x, width); x += N) {
+            unsigned char* p = bytes + 3 * x;
+            V out[3];
+            for (int part = 0; part < 3; ++part) {
+                V r, g, b;
+                channels(p + part * N, part, r, g, b);
+                const V lo = sepia_half(Isa::unpacklo8(zero, r), Isa::unpacklo8(zero, g), Isa::unpacklo8(zero, b),
+                                        weights[part][0]);
+                const V hi = sepia_half(Isa::unpackhi8(zero, r), Isa::unpackhi8(zero, g), Isa::unpackhi8(zero, b),
+                                        weights[part][1]);
+                // packus saturates the results above 255
+                out[part] = Isa::packus16(lo, hi);
+            }
+            for (int part = 0; part < 3; ++part) {
+                Isa::store(p + part * N, out[part]);
+            }
+        }
+        sepia_row_scalar(row, 1);
+        sepia_row_scalar(row + x, width - x);
+    }
+
+    // Luma and blend of one half of the bytes, widened to 16-bit lanes.
+    // gray = (77 r + 150 g + 29 b + 128) >> 8 stays below 2^16 unsigned, and
+    // the shift is a mulhi by 256. The blend is exact:
+    // ((16 d) * (16 scale)) >> 16 == (d * scale) >> 8, rounded down like the
+    // scalar shift.
+    static V saturate_half(V own, V r, V g, V b, V scale16) {
+        V gray = Isa::add16(Isa::add16(Isa::mullo16(r, Isa::set1_16(77)), Isa::mullo16(g, Isa::set1_16(150))),
+                            Isa::add16(Isa::mullo16(b, Isa::set1_16(29)), Isa::set1_16(128)));
+        gray = Isa::mulhi_u16(gray, Isa::set1_16(256));
+        const V difference = Isa::mullo16(Isa::sub16(own, gray), Isa::set1_16(16));
+        return Isa::add16(gray, Isa::mulhi_i16(difference, scale16));
+    }
+
+    static void saturation(Pixel* row, int width, int scale) {
+        if (width <= 0) {
+            return;
+        }
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(row);
+        const V zero = Isa::zero();
+        const V scale16 = Isa::set1_16(16 * scale);
+        int x = 1;
+        for (; fits_block(x, width); x += N) {
+            unsigned char* p = bytes + 3 * x;
+            V out[3];
+            for (int part = 0; part < 3; ++part) {
+                V r, g, b;
+                channels(p + part * N, part, r, g, b);
+                const V own = Isa::load(p + part * N);
+                const V lo = saturate_half(Isa::unpacklo8(own, zero), Isa::unpacklo8(r, zero),
+                                           Isa::unpacklo8(g, zero), Isa::unpacklo8(b, zero), scale16);
+                const V hi = saturate_half(Isa::unpackhi8(own, zero), Isa::unpackhi8(r, zero),
+                                           Isa::unpackhi8(g, zero), Isa::unpackhi8(b, zero), scale16);
+                // packus clamps to 0 .. 255
+                out[part] = Isa::packus16(lo, hi);
+            }
+            for (int part = 0; part < 3; ++part) {
+                Isa::store(p + part * N, out[part]);
+            }
+        }
+        saturation_row_scalar(row, 1, scale);
+        saturation_row_scalar(row + x, width - x, scale);
+    }
+
+    // Stencils write to a separate row, so the columns 1 .. width - 2 are
+    // covered with vectors and the last vector may overlap the previous one
+    static void blur(const Pixel* const* rows, Pixel* out, int width) {
+        const int end = 3 * width - 3; // bytes [3, end) are filtered
+        if (end - 3 < N) {
+            blur_row_scalar(rows, out, width);
+            return;
+        }
+        const unsigned char* up = reinterpret_cast<const unsigned char*>(rows[0]);
+        const unsigned char* mid = reinterpret_cast<const unsigned char*>(rows[1]);
+        const unsigned char* down = reinterpret_cast<const unsigned char*>(rows[2]);
+        unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+
+        // First and last columns are left unchanged
+        out[0] = rows[1][0];
+        out[width - 1] = rows[1][width - 1];
+
+        const V zero = Isa::zero();
+        const V ninth = Isa::set1_16(7282); // (s * 7282) >> 16 == s / 9 for s <= 2295
+        for (int p = 3;; p = (p + 2 * N <= end) ? p + N : end - N) {
+            V lo = zero;
+            V hi = zero;
+            for (const unsigned char* src : { up, mid, down }) {
+                for (int offset : { -3, 0, 3 }) {
+                    V v = Isa::load(src + p + offset);
+                    lo = Isa::add16(lo, Isa::unpacklo8(v, zero));
+                    hi = Isa::add16(hi, Isa::unpackhi8(v, zero));
+                }
+            }
+            Isa::store(dst + p, Isa::packus16(Isa::mulhi_u16(lo, ninth), Isa::mulhi_u16(hi, ninth)));
+            if (p + N >= end) {
+                break;
+            }
+        }
+    }
+
+    static void sharpen(const Pixel* const* rows, Pixel* out, int width) {
+        const int end = 3 * width - 3;
+        if (end - 3 < N) {
+            sharpen_row_scalar(rows, out, width);
+            return;
+        }
+        const unsigned char* up = reinterpret_cast<const unsigned char*>(rows[0]);
+        const unsigned char* mid = reinterpret_cast<const unsigned char*>(rows[1]);
+        const unsigned char* down = reinterpret_cast<const unsigned char*>(rows[2]);
+        unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+
+        out[0] = rows[1][0];
+        out[width - 1] = rows[1][width - 1];
+
+        const V zero = Isa::zero();
+        const V five = Isa::set1_16(5);
+        for (int p = 3;; p = (p + 2 * N <= end) ? p + N : end - N) {
+            V centre = Isa::load(mid + p);
+            V lo = Isa::mullo16(Isa::unpacklo8(centre, zero), five);
+            V hi = Isa::mullo16(Isa::unpackhi8(centre, zero), five);
+            for (const unsigned char* src : { up + p, down + p, mid + p - 3, mid + p + 3 }) {
+                V v = Isa::load(src);
+                lo = Isa::sub16(lo, Isa::unpacklo8(v, zero));
+                hi = Isa::sub16(hi, Isa::unpackhi8(v, zero));
+            }
+            // packus clamps the signed 16-bit sums to 0 .. 255
+            Isa::store(dst + p, Isa::packus16(lo, hi));
+            if (p + N >= end) {
+                break;
+            }
+        }
+    }
+
+    static V load16(const short* p) { return Isa::load(reinterpret_cast<const unsigned char*>(p)); }
+
+    // 16-bit planar rows: plain lane-wise maths, no phases
+    static void sobel(const short* up, const short* mid, const short* down, short* gx, short* gy, int count) {
+        constexpr int kLanes = N / 2;
+        int i = 0;
+        for (; i + kLanes <= count; i += kLanes) {
+            const V up_left = load16(up + i - 1);
+            const V up_right = load16(up + i + 1);
+            const V down_left = load16(down + i - 1);
+            const V down_right = load16(down + i + 1);
+            const V mid_diff = Isa::sub16(load16(mid + i + 1), load16(mid + i - 1));
+            const V up_centre = load16(up + i);
+            const V down_centre = load16(down + i);
+            const V x = Isa::add16(Isa::add16(Isa::sub16(up_right, up_left), Isa::sub16(down_right, down_left)),
+                                   Isa::add16(mid_diff, mid_diff));
+            const V y = Isa::sub16(Isa::add16(Isa::add16(down_left, down_right), Isa::add16(down_centre, down_centre)),
+                                   Isa::add16(Isa::add16(up_left, up_right), Isa::add16(up_centre, up_centre)));
+            Isa::store(reinterpret_cast<unsigned char*>(gx + i), x);
+            Isa::store(reinterpret_cast<unsigned char*>(gy + i), y);
+        }
+        sobel_gradient_scalar(up + i, mid + i, down + i, gx + i, gy + i, count - i);
+    }
+
+    static void lut_bytes(unsigned char* bytes, int count, const unsigned char* table) {
+        if constexpr (Isa::kHasShuffle) {
+            // The table as 16 slices of 16 entries, each in every 128-bit lane
+            V slices[16];
+            for (int k = 0; k < 16; ++k) {
+                slices[k] = Isa::broadcast_16(table + 16 * k);
+            }
+            const V bias = Isa::set1_8(0x70);
+            const V step = Isa::set1_8(16);
+            int i = 0;
+            for (; i + N <= count; i += N) {
+                V index = Isa::load(bytes + i);
+                V result = Isa::zero();
+                for (int k = 0; k < 16; ++k) {
+                    // index = byte - 16k: bytes of slice k become 0x70 .. 0x7F,
+                    // all others >= 0x80, which the shuffle turns into 0
+                    result = Isa::or_(result, Isa::shuffle8(slices[k], Isa::adds_u8(index, bias)));
+                    index = Isa::sub8(index, step);
+                }
+                Isa::store(bytes + i, result);
+            }
+            lut_bytes_scalar(bytes + i, count - i, table);
+        }
+        else {
+            lut_bytes_scalar(bytes, count, table);
+        }
+    }
+
+    // Two rows per madd: interleaving the bytes of rows k and k + 1 and
+    // widening them gives 16-bit pairs (a, b) in the lane of each byte, and
+    // madd by (w_k, w_k+1) adds both taps into its 32-bit sum. The last
+    // vector may overlap the previous one, as out is not one of the rows.
+    static void resample(const unsigned char* const* rows, const short* weights, int taps, unsigned char* out, int count) {
+        if (count < N) {
+            resample_row_scalar(rows, weights, taps, out, count);
+            return;
+        }
+        const V zero = Isa::zero();
+        const V half = Isa::set1_32(1 << (kResampleBits - 1));
+        for (int p = 0;; p = (p + 2 * N <= count) ? p + N : count - N) {
+            V sum[4] = { half, half, half, half };
+            for (int k = 0; k < taps; k += 2) {
+                const unsigned pair = static_cast<unsigned short>(weights[k]) |
+                                      (static_cast<unsigned>(static_cast<unsigned short>(weights[k + 1])) << 16);
+                const V w = Isa::set1_32(static_cast<int>(pair));
+                const V a = Isa::load(rows[k] + p);
+                const V b = Isa::load(rows[k + 1] + p);
+                const V lo = Isa::unpacklo8(a, b);
+                const V hi = Isa::unpackhi8(a, b);
+                sum[0] = Isa::add32(sum[0], Isa::madd16(Isa::unpacklo8(lo, zero), w));
+                sum[1] = Isa::add32(sum[1], Isa::madd16(Isa::unpackhi8(lo, zero), w));
+                sum[2] = Isa::add32(sum[2], Isa::madd16(Isa::unpacklo8(hi, zero), w));
+                sum[3] = Isa::add32(sum[3], Isa::madd16(Isa::unpackhi8(hi, zero), w));
+            }
+            // packs32 then packus16 saturate to 0 .. 255, like the scalar clamp
+            const V first = Isa::packs32(Isa::template srai32<kResampleBits>(sum[0]),
+                                         Isa::template srai32<kResampleBits>(sum[1]));
+            const V second = Isa::packs32(Isa::template srai32<kResampleBits>(sum[2]),
+                                          Isa::template srai32<kResampleBits>(sum[3]));
+            Isa::store(out + p, Isa::packus16(first, second));
+            if (p + N >= count) {
+                break;
+            }
+        }
+    }
+
+    // Blocks of 4 x 4 pixels: every row of 4 pixels is spread to one pixel
+    // per 32-bit lane, the 4 x 4 lanes are transposed with unpacks, and the
+    // rows are packed back to 12 bytes. The tile edges are left to the
+    // scalar kernel.
+    static void transpose(const unsigned char* src, std::ptrdiff_t src_stride, unsigned char* dst,
+                          std::ptrdiff_t dst_stride, int width, int height) {
+        if constexpr (Isa::kHasShuffle) {
+            const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+            int x = 0;
+            for (; x + 4 <= width; x += 4) {
+                int y = 0;
+                for (; y + 4 <= height; y += 4) {
+                    const unsigned char* in = src + y * src_stride + 3 * x;
+                    const __m128i r0 = Isa::shuffle8_128(load_4_pixels(in), spread);
+                    const __m128i r1 = Isa::shuffle8_128(load_4_pixels(in + src_stride), spread);
+                    const __m128i r2 = Isa::shuffle8_128(load_4_pixels(in + 2 * src_stride), spread);
+                    const __m128i r3 = Isa::shuffle8_128(load_4_pixels(in + 3 * src_stride), spread);
+                    const __m128i low01 = _mm_unpacklo_epi32(r0, r1);
+                    const __m128i low23 = _mm_unpacklo_epi32(r2, r3);
+                    const __m128i high01 = _mm_unpackhi_epi32(r0, r1);
+                    const __m128i high23 = _mm_unpackhi_epi32(r2, r3);
+                    unsigned char* out = dst + x * dst_stride + 3 * y;
+                    store_4_pixels(out, Isa::shuffle8_128(_mm_unpacklo_epi64(low01, low23), pack));
+                    store_4_pixels(out + dst_stride, Isa::shuffle8_128(_mm_unpackhi_epi64(low01, low23), pack));
+                    store_4_pixels(out + 2 * dst_stride, Isa::shuffle8_128(_mm_unpacklo_epi64(high01, high23), pack));
+                    store_4_pixels(out + 3 * dst_stride, Isa::shuffle8_128(_mm_unpackhi_epi64(high01, high23), pack));
+                }
+                transpose_tile_scalar(src + y * src_stride + 3 * x, src_stride, dst + x * dst_stride + 3 * y, dst_stride,
+                                      4, height - y);
+            }
+            transpose_tile_scalar(src + 3 * x, src_stride, dst + x * dst_stride, dst_stride, width - x, height);
+        }
+        else {
+            transpose_tile_scalar(src, src_stride, dst, dst_stride, width, height);
+        }
+    }
+
+    // 5 pixels (15 bytes) per 128-bit vector: output pixels 5m .. 5m + 4 are
+    // the input pixels that end 5m pixels before the end of the row, loaded
+    // as the 16 bytes that end there and reversed with one pshufb. The 16th
+    // byte stored is overwritten by the next vector or by the scalar tail.
+    static void reverse(const Pixel* in, Pixel* out, int width) {
+        if constexpr (Isa::kHasShuffle) {
+            const __m128i mirror = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4, 5, 6, 1, 2, 3, -1);
+            const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+            unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+            const int bytes = 3 * width;
+            int x = 0;
+            for (; 3 * x + 16 <= bytes; x += 5) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + bytes - 3 * x - 16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * x), Isa::shuffle8_128(v, mirror));
+            }
+            reverse_row_scalar(in, out + x, width - x);
+        }
+        else {
+            reverse_row_scalar(in, out, width);
+        }
+    }
+
+    static const RowKernels& table() {
+        static constexpr RowKernels kernels = { grayscale, threshold, sepia, saturation, blur, sharpen, sobel, lut_bytes,
+                                                resample, transpose, reverse };
+        return kernels;
+    }
+};
+
+} // namespace
+
+
+#endif // !_FILTERS_SIMD_KERNELS_H
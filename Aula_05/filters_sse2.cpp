@@ -0,0 +1,69 @@
+#include "filters_simd.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <initializer_list>
+
+#include <emmintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("sse2")
+#endif
+
+namespace {
+
+struct Sse2 {
+    typedef __m128i V;
+    static constexpr int kBytes = 16;
+    static constexpr bool kHasShuffle = false; // pshufb is SSSE3
+
+    static V load(const unsigned char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(unsigned char* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V zero() { return _mm_setzero_si128(); }
+    static V set1_8(int x) { return _mm_set1_epi8(static_cast<char>(x)); }
+    static V set1_16(int x) { return _mm_set1_epi16(static_cast<short>(x)); }
+
+    static V and_(V a, V b) { return _mm_and_si128(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+    static V add8(V a, V b) { return _mm_add_epi8(a, b); }
+    static V sub8(V a, V b) { return _mm_sub_epi8(a, b); }
+    static V adds_u8(V a, V b) { return _mm_adds_epu8(a, b); }
+    static V add16(V a, V b) { return _mm_add_epi16(a, b); }
+    static V sub16(V a, V b) { return _mm_sub_epi16(a, b); }
+    static V mullo16(V a, V b) { return _mm_mullo_epi16(a, b); }
+    static V mulhi_u16(V a, V b) { return _mm_mulhi_epu16(a, b); }
+    static V mulhi_i16(V a, V b) { return _mm_mulhi_epi16(a, b); }
+    static V cmpgt16(V a, V b) { return _mm_cmpgt_epi16(a, b); }
+    static V unpacklo8(V a, V b) { return _mm_unpacklo_epi8(a, b); }
+    static V unpackhi8(V a, V b) { return _mm_unpackhi_epi8(a, b); }
+    static V packus16(V a, V b) { return _mm_packus_epi16(a, b); }
+    static V packs16(V a, V b) { return _mm_packs_epi16(a, b); }
+    static V set1_32(int x) { return _mm_set1_epi32(x); }
+    static V add32(V a, V b) { return _mm_add_epi32(a, b); }
+    template <int Shift>
+    static V srai32(V a) { return _mm_srai_epi32(a, Shift); }
+    static V madd16(V a, V b) { return _mm_madd_epi16(a, b); }
+    static V packs32(V a, V b) { return _mm_packs_epi32(a, b); }
+};
+
+} // namespace
+
+#include "filters_simd_kernels.h"
+
+const RowKernels& sse2_row_kernels() {
+    return SimdKernels<Sse2>::table();
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+const RowKernels& sse2_row_kernels() {
+    return scalar_row_kernels();
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "geometry.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "filters_simd.h"
+#include "parallel.h"
+
+namespace {
+
+// Largest side of the tiles moved at once: 64 rows of 64 pixels are 12 KB
+// to read and 12 KB to write
+constexpr int kTilePixels = 64;
+
+// A transpose from `source` to `target`; the origins and strides already
+// include any flip of the rows
+struct TransposeJob {
+    const unsigned char* source;
+    std::ptrdiff_t source_stride;
+    unsigned char* target;
+    std::ptrdiff_t target_stride;
+    const RowKernels* kernels;
+};
+
+// Source columns [x0, x1) of rows [y0, y1): halve the longer side until the
+// piece is a tile
+void transpose_recursive(const TransposeJob& job, int x0, int x1, int y0, int y1) {
+    if (x1 - x0 <= kTilePixels && y1 - y0 <= kTilePixels) {
+        job.kernels->transpose(job.source + y0 * job.source_stride + 3 * x0, job.source_stride,
+                               job.target + x0 * job.target_stride + 3 * y0, job.target_stride, x1 - x0, y1 - y0);
+        return;
+    }
+    if (x1 - x0 >= y1 - y0) {
+        const int middle = x0 + (x1 - x0) / 2;
+        transpose_recursive(job, x0, middle, y0, y1);
+        transpose_recursive(job, middle, x1, y0, y1);
+    }
+    else {
+        const int middle = y0 + (y1 - y0) / 2;
+        transpose_recursive(job, x0, x1, y0, middle);
+        transpose_recursive(job, x0, x1, middle, y1);
+    }
+}
+
+// flip_source: read the source rows bottom-up; flip_target: write the target rows bottom-up
+Image transpose_copy(const ImageView& source, bool flip_source, bool flip_target, int num_threads) {
+    if (source.empty()) {
+        return Image();
+    }
+    const int width = source.width();
+    const int height = source.height();
+    Image target(height, width);
+
+    TransposeJob job;
+    job.source_stride = static_cast<std::ptrdiff_t>(source.stride());
+    job.source = source.data() + (flip_source ? (height - 1) * job.source_stride : 0);
+    job.target_stride = static_cast<std::ptrdiff_t>(target.stride());
+    job.target = target.data() + (flip_target ? (width - 1) * job.target_stride : 0);
+    if (flip_source) {
+        job.source_stride = -job.source_stride;
+    }
+    if (flip_target) {
+        job.target_stride = -job.target_stride;
+    }
+    job.kernels = &active_row_kernels();
+
+    // Every thread writes the target rows of its own source columns
+    parallel_for(0, width, num_threads, [&](int start, int stop) {
+        transpose_recursive(job, start, stop, 0, height);
+    });
+    return target;
+}
+
+} // namespace
+
+void transpose_tile_scalar(const unsigned char* src, std::ptrdiff_t src_stride, unsigned char* dst, std::ptrdiff_t dst_stride,
+                           int width, int height) {
+    for (int x = 0; x < width; ++x) {
+        unsigned char* out = dst + x * dst_stride;
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(out + 3 * y, src + y * src_stride + 3 * x, 3);
+        }
+    }
+}
+
+void reverse_row_scalar(const Pixel* in, Pixel* out, int width) {
+    for (int x = 0; x < width; ++x) {
+        out[x] = in[width - 1 - x];
+    }
+}
+
+Image transpose_image(const ImageView& source, int num_threads) {
+    return transpose_copy(source, false, false, num_threads);
+}
+
+Image rotate_image(const ImageView& source, Rotation rotation, int num_threads) {
+    switch (rotation) {
+    case Rotation::Rotate90:
+        return transpose_copy(source, true, false, num_threads);
+    case Rotation::Rotate270:
+        return transpose_copy(source, false, true, num_threads);
+    case Rotation::Rotate180:
+    default: {
+        if (source.empty()) {
+            return Image();
+        }
+        Image target(source.width(), source.height());
+        const RowKernels& kernels = active_row_kernels();
+        const int last = source.height() - 1;
+        parallel_for(0, source.height(), num_threads, [&](int start, int stop) {
+            for (int y = start; y < stop; ++y) {
+                kernels.reverse(source.row(last - y), target.row(y), source.width());
+            }
+        });
+        return target;
+    }
+    }
+}
+
+void transpose_filter(Image& image, int num_threads) {
+    if (!image.empty()) {
+        image = transpose_image(image, num_threads);
+    }
+}
+
+void rotate_filter(Image& image, Rotation rotation, int num_threads) {
+    if (image.empty()) {
+        return;
+    }
+    if (rotation != Rotation::Rotate180) {
+        image = rotate_image(image, rotation, num_threads);
+        return;
+    }
+    // Half turn in place: rows y and height - 1 - y swap, each reversed
+    const RowKernels& kernels = active_row_kernels();
+    const int width = image.width();
+    const int last = image.height() - 1;
+    parallel_for(0, (image.height() + 1) / 2, num_threads, [&](int start, int stop) {
+        std::vector<Pixel> top(width);
+        for (int y = start; y < stop; ++y) {
+            std::memcpy(top.data(), image.row(y), width * sizeof(Pixel));
+            if (y != last - y) {
+                kernels.reverse(image.row(last - y), image.row(y), width);
+            }
+            kernels.reverse(top.data(), image.row(last - y), width);
+        }
+    });
+}
+
+void flip_horizontal_filter(Image& image, int num_threads) {
+    if (image.empty()) {
+        return;
+    }
+    const RowKernels& kernels = active_row_kernels();
+    const int width = image.width();
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        std::vector<Pixel> row(width);
+        for (int y = start; y < stop; ++y) {
+            std::memcpy(row.data(), image.row(y), width * sizeof(Pixel));
+            kernels.reverse(row.data(), image.row(y), width);
+        }
+    });
+}
+
+void flip_vertical_filter(Image& image, int num_threads) {
+    if (image.empty()) {
+        return;
+    }
+    const std::size_t bytes = image.width() * sizeof(Pixel);
+    const int last = image.height() - 1;
+    parallel_for(0, image.height() / 2, num_threads, [&](int start, int stop) {
+        std::vector<Pixel> top(image.width());
+        for (int y = start; y < stop; ++y) {
+            std::memcpy(top.data(), image.row(y), bytes);
+            std::memcpy(image.row(y), image.row(last - y), bytes);
+            std::memcpy(image.row(last - y), top.data(), bytes);
+        }
+    });
+}
+
+Filter make_transpose_filter() {
+    Filter filter(FilterFunction([](Image& image) { transpose_filter(image); }));
+    filter.name = "transpose";
+    return filter;
+}
+
+Filter make_rotate_filter(Rotation rotation) {
+    static const char* const kNames[] = { "rotate-90", "rotate-180", "rotate-270" };
+    Filter filter([rotation](Image& image) { rotate_filter(image, rotation); });
+    filter.name = kNames[static_cast<int>(rotation)];
+    return filter;
+}
+
+Filter make_flip_horizontal_filter() {
+    Filter filter(FilterFunction([](Image& image) { flip_horizontal_filter(image); }));
+    filter.name = "flip-horizontal";
+    return filter;
+}
+
+Filter make_flip_vertical_filter() {
+    Filter filter(FilterFunction([](Image& image) { flip_vertical_filter(image); }));
+    filter.name = "flip-vertical";
+    return filter;
+}
@@ -0,0 +1,41 @@
+#ifndef _GEOMETRY_H
+#define _GEOMETRY_H
+
+#include "filters.h"
+#include "image.h"
+
+// Clockwise rotations
+enum class Rotation {
+    Rotate90,
+    Rotate180,
+    Rotate270
+};
+
+// Transpose (pixel (x, y) goes to (y, x)) and the quarter turns, which are
+// a transpose of the rows read bottom-up (90) or written bottom-up (270).
+// A column walk touches a new page for every pixel of a large image, so the
+// image is cut in half along its longer side again and again until a piece
+// is at most 64 x 64 pixels, whose rows stay in the L1 cache and TLB
+// whatever their size (cache-oblivious); those tiles are moved in blocks of
+// 4 x 4 pixels with pshufb. The target rows are split between threads.
+//
+// These make a new image, as the width and height swap. The source is any
+// ImageView, an stbi_load buffer included.
+Image transpose_image(const ImageView& source, int num_threads = 0);
+Image rotate_image(const ImageView& source, Rotation rotation, int num_threads = 0);
+
+// In place versions of the above, and the flips. Flips and the half turn
+// read and write whole rows in order, so they need no tiling: pixels are
+// reversed with pshufb 5 at a time and the rows are split between threads.
+void transpose_filter(Image& image, int num_threads = 0);
+void rotate_filter(Image& image, Rotation rotation, int num_threads = 0);
+void flip_horizontal_filter(Image& image, int num_threads = 0);
+void flip_vertical_filter(Image& image, int num_threads = 0);
+
+Filter make_transpose_filter();
+Filter make_rotate_filter(Rotation rotation);
+Filter make_flip_horizontal_filter();
+Filter make_flip_vertical_filter();
+
+
+#endif // !_GEOMETRY_H
@@ -0,0 +1,396 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "parallel.h"
+
+namespace {
+
+// Interleaved copies of the bins of one thread: pixel x counts into copy x % kCopies
+constexpr int kCopies = 4;
+constexpr int kSumLevels = 3 * 255 + 1;
+
+struct BandCounts {
+    std::uint32_t channel[kCopies][3][256];
+    std::uint32_t sum[kCopies][kSumLevels];
+};
+
+// Counts rows [y0, y1); without Channels only the r + g + b sums
+template <bool Channels>
+void count_rows(const Image& image, int y0, int y1, BandCounts& counts) {
+    const int width = image.width();
+    for (int y = y0; y < y1; ++y) {
+        const Pixel* row = image.row(y);
+        int x = 0;
+        for (; x + kCopies <= width; x += kCopies) {
+            for (int k = 0; k < kCopies; ++k) {
+                const Pixel& pixel = row[x + k];
+                if constexpr (Channels) {
+                    ++counts.channel[k][0][pixel.r];
+                    ++counts.channel[k][1][pixel.g];
+                    ++counts.channel[k][2][pixel.b];
+                }
+                ++counts.sum[k][pixel.r + pixel.g + pixel.b];
+            }
+        }
+        for (; x < width; ++x) {
+            const Pixel& pixel = row[x];
+            if constexpr (Channels) {
+                ++counts.channel[0][0][pixel.r];
+                ++counts.channel[0][1][pixel.g];
+                ++counts.channel[0][2][pixel.b];
+            }
+            ++counts.sum[0][pixel.r + pixel.g + pixel.b];
+        }
+    }
+}
+
+// Start of part t when n pixels are cut into `parts` nearly equal parts
+inline int split_point(int t, int parts, int n) {
+    return static_cast<int>(static_cast<long long>(t) * n / parts);
+}
+
+// One band of rows per thread, each counted into its own bins
+template <bool Channels>
+std::vector<BandCounts> count_bands(const Image& image, int num_threads) {
+    const int height = image.height();
+    const int threads = std::min(default_thread_count(num_threads), height);
+    std::vector<BandCounts> bands(threads); // zeroed
+    parallel_for(0, threads, threads, [&](int start, int stop) {
+        for (int t = start; t < stop; ++t) {
+            count_rows<Channels>(image, split_point(t, threads, height), split_point(t + 1, threads, height), bands[t]);
+        }
+    });
+    return bands;
+}
+
+void merge_luma(const BandCounts& counts, LevelCounts& luma) {
+    for (int k = 0; k < kCopies; ++k) {
+        for (int s = 0; s < kSumLevels; ++s) {
+            luma[s / 3] += counts.sum[k][s];
+        }
+    }
+}
+
+// Equalization table of one channel from its counts: cumulative counts
+// scaled so the first level in use maps to 0 and the last to 255
+template <typename Counts>
+void equalization_table(const Counts& counts, std::uint64_t total, unsigned char* table) {
+    std::uint64_t first = 0;
+    for (int v = 0; v < 256 && first == 0; ++v) {
+        first = counts[v];
+    }
+    if (total <= first) {
+        for (int v = 0; v < 256; ++v) {
+            table[v] = static_cast<unsigned char>(v);
+        }
+        return;
+    }
+    const std::uint64_t range = total - first;
+    std::uint64_t cumulative = 0;
+    for (int v = 0; v < 256; ++v) {
+        cumulative += counts[v];
+        const std::uint64_t above = (cumulative > first) ? cumulative - first : 0;
+        table[v] = static_cast<unsigned char>((above * 255 + range / 2) / range);
+    }
+}
+
+void apply_lut_rows(Image& image, const ChannelLut& lut, int num_threads) {
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        for (int y = start; y < stop; ++y) {
+            lut_row(image.row(y), image.width(), lut);
+        }
+    });
+}
+
+// For every pixel along an axis: the tiles whose centres are on either side
+// of it and the weight of the second, 0 .. 256. Pixels before the first
+// centre or after the last use that tile alone.
+struct TileBlend {
+    std::vector<int> first;
+    std::vector<int> second;
+    std::vector<int> weight;
+};
+
+TileBlend tile_blend(int tiles, int n) {
+    TileBlend blend;
+    blend.first.resize(n);
+    blend.second.resize(n);
+    blend.weight.resize(n);
+    std::vector<double> centre(tiles);
+    for (int t = 0; t < tiles; ++t) {
+        centre[t] = 0.5 * (split_point(t, tiles, n) + split_point(t + 1, tiles, n) - 1);
+    }
+    int t = 0;
+    for (int i = 0; i < n; ++i) {
+        while (t + 1 < tiles && centre[t + 1] <= i) {
+            ++t;
+        }
+        if (i <= centre[0] || t + 1 == tiles) {
+            blend.first[i] = blend.second[i] = t;
+            blend.weight[i] = 0;
+        }
+        else {
+            blend.first[i] = t;
+            blend.second[i] = t + 1;
+            blend.weight[i] = static_cast<int>(std::lround(256.0 * (i - centre[t]) / (centre[t + 1] - centre[t])));
+        }
+    }
+    return blend;
+}
+
+// Clipped equalization table of one channel of one tile. The counts are
+// consumed: clipping and spreading the excess happen in place, so they are
+// no longer the tile's histogram afterwards (clahe_filter recounts every
+// row of tiles). `pixels` is the tile's pixel count.
+void clahe_table(std::uint32_t* counts, int pixels, float clip_limit, unsigned char* table) {
+    if (clip_limit > 0.0f) {
+        const std::uint32_t limit = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(clip_limit * pixels / 256.0f));
+        std::uint32_t excess = 0;
+        for (int v = 0; v < 256; ++v) {
+            if (counts[v] > limit) {
+                excess += counts[v] - limit;
+                counts[v] = limit;
+            }
+        }
+        // Spread evenly; the remainder goes one each to levels spaced across the range
+        const std::uint32_t share = excess / 256;
+        const std::uint32_t remainder = excess % 256;
+        for (int v = 0; v < 256; ++v) {
+            counts[v] += share;
+        }
+        if (remainder > 0) {
+            const std::uint32_t step = 256 / remainder;
+            for (std::uint32_t i = 0; i < remainder; ++i) {
+                ++counts[i * step];
+            }
+        }
+    }
+    std::uint32_t cumulative = 0;
+    for (int v = 0; v < 256; ++v) {
+        cumulative += counts[v];
+        table[v] = static_cast<unsigned char>(std::min<std::uint64_t>(255, (cumulative * 255ull + pixels / 2) / pixels));
+    }
+}
+
+} // namespace
+
+Histogram compute_histogram(const Image& image, int num_threads) {
+    Histogram histogram;
+    if (image.empty()) {
+        return histogram;
+    }
+    for (const BandCounts& counts : count_bands<true>(image, num_threads)) {
+        for (int k = 0; k < kCopies; ++k) {
+            for (int v = 0; v < 256; ++v) {
+                histogram.r[v] += counts.channel[k][0][v];
+                histogram.g[v] += counts.channel[k][1][v];
+                histogram.b[v] += counts.channel[k][2][v];
+            }
+        }
+        merge_luma(counts, histogram.luma);
+    }
+    histogram.pixels = static_cast<std::uint64_t>(image.width()) * image.height();
+    return histogram;
+}
+
+LevelCounts compute_luma_histogram(const Image& image, int num_threads) {
+    LevelCounts luma{};
+    if (image.empty()) {
+        return luma;
+    }
+    for (const BandCounts& counts : count_bands<false>(image, num_threads)) {
+        merge_luma(counts, luma);
+    }
+    return luma;
+}
+
+ChannelLut equalization_lut(const Histogram& histogram) {
+    ChannelLut lut;
+    equalization_table(histogram.r, histogram.pixels, lut.r.data());
+    equalization_table(histogram.g, histogram.pixels, lut.g.data());
+    equalization_table(histogram.b, histogram.pixels, lut.b.data());
+    return lut;
+}
+
+void equalize_filter(Image& image, int num_threads) {
+    if (image.empty()) {
+        return;
+    }
+    apply_lut_rows(image, equalization_lut(compute_histogram(image, num_threads)), num_threads);
+}
+
+Filter make_equalize_filter() {
+    Filter filter(FilterFunction([](Image& image) { equalize_filter(image); }));
+    filter.name = "equalize";
+    return filter;
+}
+
+void clahe_filter(Image& image, int tiles_x, int tiles_y, float clip_limit, int num_threads) {
+    if (image.empty()) {
+        return;
+    }
+    const int width = image.width();
+    const int height = image.height();
+    tiles_x = std::clamp(tiles_x, 1, width);
+    tiles_y = std::clamp(tiles_y, 1, height);
+
+    // Equalization tables of every tile, 3 x 256 bytes each, by rows of tiles
+    std::vector<unsigned char> tables(static_cast<std::size_t>(tiles_x) * tiles_y * 3 * 256);
+    parallel_for(0, tiles_y, num_threads, [&](int start, int stop) {
+        std::vector<std::uint32_t> counts(static_cast<std::size_t>(tiles_x) * 3 * 256);
+        for (int ty = start; ty < stop; ++ty) {
+            std::fill(counts.begin(), counts.end(), 0u);
+            const int y0 = split_point(ty, tiles_y, height);
+            const int y1 = split_point(ty + 1, tiles_y, height);
+            for (int tx = 0; tx < tiles_x; ++tx) {
+                const int x0 = split_point(tx, tiles_x, width);
+                const int x1 = split_point(tx + 1, tiles_x, width);
+                std::uint32_t* tile = &counts[static_cast<std::size_t>(tx) * 3 * 256];
+                for (int y = y0; y < y1; ++y) {
+                    const Pixel* row = image.row(y);
+                    for (int x = x0; x < x1; ++x) {
+                        ++tile[row[x].r];
+                        ++tile[256 + row[x].g];
+                        ++tile[512 + row[x].b];
+                    }
+                }
+                const int pixels = (x1 - x0) * (y1 - y0);
+                unsigned char* table = &tables[(static_cast<std::size_t>(ty) * tiles_x + tx) * 3 * 256];
+                for (int c = 0; c < 3; ++c) {
+                    clahe_table(tile + c * 256, pixels, clip_limit, table + c * 256);
+                }
+            }
+        }
+    });
+
+    const TileBlend columns = tile_blend(tiles_x, width);
+    const TileBlend rows = tile_blend(tiles_y, height);
+    parallel_for(0, height, num_threads, [&](int start, int stop) {
+        for (int y = start; y < stop; ++y) {
+            const unsigned char* top = &tables[static_cast<std::size_t>(rows.first[y]) * tiles_x * 3 * 256];
+            const unsigned char* bottom = &tables[static_cast<std::size_t>(rows.second[y]) * tiles_x * 3 * 256];
+            const int wy = rows.weight[y];
+            unsigned char* row = reinterpret_cast<unsigned char*>(image.row(y));
+            for (int x = 0; x < width; ++x) {
+                const int left = columns.first[x] * 3 * 256;
+                const int right = columns.second[x] * 3 * 256;
+                const int wx = columns.weight[x];
+                for (int c = 0; c < 3; ++c) {
+                    const int v = row[3 * x + c] + c * 256;
+                    const int upper = (256 - wx) * top[left + v] + wx * top[right + v];
+                    const int lower = (256 - wx) * bottom[left + v] + wx * bottom[right + v];
+                    row[3 * x + c] = static_cast<unsigned char>(((256 - wy) * upper + wy * lower + 32768) >> 16);
+                }
+            }
+        }
+    });
+}
+
+Filter make_clahe_filter(int tiles_x, int tiles_y, float clip_limit) {
+    Filter filter([tiles_x, tiles_y, clip_limit](Image& image) { clahe_filter(image, tiles_x, tiles_y, clip_limit); });
+    filter.name = "clahe";
+    return filter;
+}
+
+std::vector<unsigned char> otsu_thresholds(const LevelCounts& counts, int thresholds) {
+    thresholds = std::clamp(thresholds, 1, 255);
+
+    // Prefix sums of the counts and of count * level
+    std::array<double, 257> weight{};
+    std::array<double, 257> moment{};
+    for (int v = 0; v < 256; ++v) {
+        weight[v + 1] = weight[v] + static_cast<double>(counts[v]);
+        moment[v + 1] = moment[v] + static_cast<double>(counts[v]) * v;
+    }
+    // Between-class variance, up to constants: sum of moment^2 / weight over the classes
+    auto score = [&](int first, int last) {
+        const double w = weight[last + 1] - weight[first];
+        const double m = moment[last + 1] - moment[first];
+        return (w > 0.0) ? m * m / w : 0.0;
+    };
+
+    // best[j][t]: levels 0 .. t cut into j + 1 classes; cut[j][t]: last level of class j - 1
+    std::vector<std::array<double, 256>> best(thresholds + 1);
+    std::vector<std::array<unsigned char, 256>> cut(thresholds + 1);
+    for (int t = 0; t < 256; ++t) {
+        best[0][t] = score(0, t);
+    }
+    for (int j = 1; j <= thresholds; ++j) {
+        for (int t = j; t < 256; ++t) {
+            // Ties go to the lowest cut
+            double top = -1.0;
+            for (int s = j - 1; s < t; ++s) {
+                const double value = best[j - 1][s] + score(s + 1, t);
+                if (value > top) {
+                    top = value;
+                    cut[j][t] = static_cast<unsigned char>(s);
+                }
+            }
+            best[j][t] = top;
+        }
+    }
+
+    std::vector<unsigned char> result(thresholds);
+    for (int j = thresholds, t = 255; j > 0; --j) {
+        result[j - 1] = cut[j][t];
+        t = cut[j][t];
+    }
+    return result;
+}
+
+unsigned char otsu_threshold(const LevelCounts& counts) {
+    return otsu_thresholds(counts, 1)[0];
+}
+
+unsigned char otsu_threshold_filter(Image& image, int num_threads) {
+    if (image.empty()) {
+        return 0;
+    }
+    const unsigned char threshold = otsu_threshold(compute_luma_histogram(image, num_threads));
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        for (int y = start; y < stop; ++y) {
+            threshold_row(image.row(y), image.width(), threshold);
+        }
+    });
+    return threshold;
+}
+
+std::vector<unsigned char> otsu_multilevel_filter(Image& image, int thresholds, int num_threads) {
+    if (image.empty()) {
+        return {};
+    }
+    const std::vector<unsigned char> levels = otsu_thresholds(compute_luma_histogram(image, num_threads), thresholds);
+    const int classes = static_cast<int>(levels.size()) + 1;
+
+    // Gray level -> output level of its class
+    ChannelLut lut;
+    int c = 0;
+    for (int v = 0; v < 256; ++v) {
+        while (c + 1 < classes && v > levels[c]) {
+            ++c;
+        }
+        lut.r[v] = lut.g[v] = lut.b[v] = static_cast<unsigned char>((c * 255 + (classes - 1) / 2) / (classes - 1));
+    }
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        for (int y = start; y < stop; ++y) {
+            grayscale_row(image.row(y), image.width());
+            lut_row(image.row(y), image.width(), lut);
+        }
+    });
+    return levels;
+}
+
+Filter make_otsu_threshold_filter() {
+    Filter filter(FilterFunction([](Image& image) { otsu_threshold_filter(image); }));
+    filter.name = "otsu";
+    return filter;
+}
+
+Filter make_otsu_multilevel_filter(int thresholds) {
+    Filter filter([thresholds](Image& image) { otsu_multilevel_filter(image, thresholds); });
+    filter.name = "otsu-multilevel";
+    return filter;
+}
@@ -0,0 +1,77 @@
+#ifndef _HISTOGRAM_H
+#define _HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "filters.h"
+#include "image.h"
+
+typedef std::array<std::uint64_t, 256> LevelCounts;
+
+// Counts of the 256 levels of each channel, and of the gray level
+// (r + g + b) / 3 that grayscale_filter and threshold_filter use
+struct Histogram {
+    LevelCounts r{};
+    LevelCounts g{};
+    LevelCounts b{};
+    LevelCounts luma{};
+    std::uint64_t pixels = 0;
+};
+
+// Histogram of the whole image in one read. The rows are split into one
+// band per thread, and every thread counts into its own bins (four
+// interleaved copies, so runs of one value do not wait on the same
+// counter); the bands are added up once at the end. The gray level is
+// counted as r + g + b and divided by 3 when merging.
+Histogram compute_histogram(const Image& image, int num_threads = 0);
+// The gray level counts alone, the same way (one counter per pixel instead of four)
+LevelCounts compute_luma_histogram(const Image& image, int num_threads = 0);
+
+// Global histogram equalization, each channel on its own: level v goes to
+// 255 (cdf(v) - cdf(first level)) / (pixels - cdf(first level)), rounded,
+// so the levels in use spread over 0 .. 255. A channel with one level only
+// is left unchanged.
+ChannelLut equalization_lut(const Histogram& histogram);
+void equalize_filter(Image& image, int num_threads = 0);
+
+Filter make_equalize_filter();
+
+// Contrast-limited adaptive histogram equalization (CLAHE), per channel.
+// The image is cut into tiles_x x tiles_y tiles and every tile gets its own
+// equalization table from its histogram, clipped at clip_limit times the
+// mean count per level (<= 0: no clipping) with the clipped counts spread
+// evenly over all levels. Each pixel blends the tables of the four tiles
+// whose centres surround it, bilinearly in 8-bit fixed point, so there are
+// no seams at the tile edges.
+//
+// Tile histograms are counted by rows of tiles and the pixels are mapped by
+// bands of rows, both split between threads.
+void clahe_filter(Image& image, int tiles_x = 8, int tiles_y = 8, float clip_limit = 2.0f, int num_threads = 0);
+
+Filter make_clahe_filter(int tiles_x = 8, int tiles_y = 8, float clip_limit = 2.0f);
+
+// Otsu's method: the thresholds t1 < t2 < ... that cut the levels into
+// classes (.., t1], (t1, t2], ... with the largest variance between the
+// class means, which for one threshold separates the two modes of a
+// bimodal histogram. Searched exactly for any number of thresholds by
+// dynamic programming over the 256 levels (thresholds x 256^2 / 2 steps,
+// nothing next to the histogram itself); ties go to the lowest threshold.
+std::vector<unsigned char> otsu_thresholds(const LevelCounts& counts, int thresholds);
+unsigned char otsu_threshold(const LevelCounts& counts);
+
+// threshold_filter with Otsu's threshold of the gray level histogram: one
+// parallel read of the image to count, then threshold_row over bands of
+// rows. Returns the threshold used.
+unsigned char otsu_threshold_filter(Image& image, int num_threads = 0);
+
+// Gray image with `thresholds` Otsu thresholds: class i of thresholds + 1
+// becomes level 255 i / thresholds. Returns the thresholds used.
+std::vector<unsigned char> otsu_multilevel_filter(Image& image, int thresholds, int num_threads = 0);
+
+Filter make_otsu_threshold_filter();
+Filter make_otsu_multilevel_filter(int thresholds);
+
+
+#endif // !_HISTOGRAM_H
@@ -0,0 +1,97 @@
+#include "image.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+// Constructor: one aligned allocation for the whole raster
+Image::Image(int width, int height, std::size_t stride)
+    : m_Width(width), m_Height(height)
+{
+    m_Stride = stride ? stride : width * sizeof(Pixel);
+    if (size_bytes() > 0) {
+        m_Data = static_cast<unsigned char*>(::operator new(size_bytes(), std::align_val_t(alignment)));
+    }
+}
+
+Image::Image(const ImageView& view)
+    : Image(view.width(), view.height())
+{
+    if (!m_Data) {
+        return;
+    }
+    if (view.is_packed()) {
+        std::memcpy(m_Data, view.data(), size_bytes());
+    }
+    else {
+        const std::size_t row_bytes = m_Width * sizeof(Pixel);
+        for (int i = 0; i < m_Height; ++i) {
+            std::memcpy(row(i), view.row(i), row_bytes);
+        }
+    }
+}
+
+Image Image::adopt(unsigned char* data, int width, int height, std::size_t stride, void (*deleter)(void*)) {
+    Image image;
+    image.m_Data = data;
+    image.m_Width = width;
+    image.m_Height = height;
+    image.m_Stride = stride ? stride : width * sizeof(Pixel);
+    image.m_Deleter = deleter;
+    return image;
+}
+
+// Destructor
+Image::~Image() {
+    release();
+}
+
+Image::Image(const Image& other)
+    : Image(other.m_Width, other.m_Height, other.m_Stride)
+{
+    if (m_Data) {
+        std::memcpy(m_Data, other.m_Data, size_bytes());
+    }
+}
+
+Image& Image::operator=(const Image& other) {
+    if (this != &other) {
+        Image copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+Image::Image(Image&& other) noexcept
+    : m_Data(std::exchange(other.m_Data, nullptr)),
+      m_Width(std::exchange(other.m_Width, 0)),
+      m_Height(std::exchange(other.m_Height, 0)),
+      m_Stride(std::exchange(other.m_Stride, 0)),
+      m_Deleter(std::exchange(other.m_Deleter, nullptr))
+{
+}
+
+Image& Image::operator=(Image&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Width = std::exchange(other.m_Width, 0);
+        m_Height = std::exchange(other.m_Height, 0);
+        m_Stride = std::exchange(other.m_Stride, 0);
+        m_Deleter = std::exchange(other.m_Deleter, nullptr);
+    }
+    return *this;
+}
+
+void Image::release() {
+    if (m_Data) {
+        if (m_Deleter) {
+            m_Deleter(m_Data);
+        }
+        else {
+            ::operator delete(m_Data, std::align_val_t(alignment));
+        }
+        m_Data = nullptr;
+        m_Deleter = nullptr;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef _IMAGE_H
+#define _IMAGE_H
+
+#include <cstddef>
+
+// Pixel RGB (0->>255) 8 bits per channel, packed in 3 bytes
+struct Pixel {
+    unsigned char r, g, b;
+};
+
+static_assert(sizeof(Pixel) == 3, "Pixel must be 3 packed bytes (RGB)");
+
+class ImageView;
+
+// Class Image
+//
+// Contiguous RGB raster: the whole image lives in ONE cache-line-aligned
+// allocation, row after row. `stride` is the distance in bytes between the
+// start of two consecutive rows (width * 3 when the rows are packed), so
+// row(y) is just data() + y * stride and filters stream linearly through memory.
+//
+// An Image can also adopt a buffer it did not allocate (e.g. the result of
+// stbi_load); the buffer is then released with the deleter given to adopt().
+
+class Image
+{
+public:
+    static constexpr std::size_t alignment = 64; // cache line
+
+    Image() = default;
+    // stride = 0 -> packed rows (width * sizeof(Pixel))
+    Image(int width, int height, std::size_t stride = 0);
+    ~Image();
+
+    // Materialize a private, writable copy of a view (packed rows)
+    explicit Image(const ImageView& view);
+
+    // Take ownership of an external RGB buffer without copying it
+    static Image adopt(unsigned char* data, int width, int height, std::size_t stride, void (*deleter)(void*));
+
+    Image(const Image& other);
+    Image& operator=(const Image& other);
+    Image(Image&& other) noexcept;
+    Image& operator=(Image&& other) noexcept;
+
+    int width() const { return m_Width; }
+    int height() const { return m_Height; }
+    std::size_t stride() const { return m_Stride; }
+    std::size_t size_bytes() const { return m_Stride * m_Height; }
+    bool empty() const { return m_Data == nullptr; }
+    bool is_packed() const { return m_Stride == m_Width * sizeof(Pixel); }
+
+    unsigned char* data() { return m_Data; }
+    const unsigned char* data() const { return m_Data; }
+
+    Pixel* row(int y) { return reinterpret_cast<Pixel*>(m_Data + y * m_Stride); }
+    const Pixel* row(int y) const { return reinterpret_cast<const Pixel*>(m_Data + y * m_Stride); }
+
+    Pixel& at(int x, int y) { return row(y)[x]; }
+    const Pixel& at(int x, int y) const { return row(y)[x]; }
+
+private:
+    void release();
+
+    unsigned char* m_Data = nullptr;
+    int m_Width = 0;
+    int m_Height = 0;
+    std::size_t m_Stride = 0;
+    void (*m_Deleter)(void*) = nullptr; // nullptr -> our own aligned allocation
+};
+
+// Class ImageView
+//
+// Read-only, non-owning view of an RGB raster: an Image, or pixels that live
+// somewhere else (e.g. a memory-mapped PPM file). Anything that only reads
+// pixels takes an ImageView, so an Image can be passed directly.
+
+class ImageView
+{
+public:
+    ImageView() = default;
+    ImageView(const unsigned char* data, int width, int height, std::size_t stride = 0)
+        : m_Data(data), m_Width(width), m_Height(height), m_Stride(stride ? stride : width * sizeof(Pixel)) {}
+    ImageView(const Image& image)
+        : ImageView(image.data(), image.width(), image.height(), image.stride()) {}
+
+    int width() const { return m_Width; }
+    int height() const { return m_Height; }
+    std::size_t stride() const { return m_Stride; }
+    std::size_t size_bytes() const { return m_Stride * m_Height; }
+    bool empty() const { return m_Data == nullptr; }
+    bool is_packed() const { return m_Stride == m_Width * sizeof(Pixel); }
+
+    const unsigned char* data() const { return m_Data; }
+    const Pixel* row(int y) const { return reinterpret_cast<const Pixel*>(m_Data + y * m_Stride); }
+    const Pixel& at(int x, int y) const { return row(y)[x]; }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    int m_Width = 0;
+    int m_Height = 0;
+    std::size_t m_Stride = 0;
+};
+
+
+#endif // !_IMAGE_H
@@ -0,0 +1,135 @@
+#include "mapped_ppm.h"
+
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedPpm::~MappedPpm() {
+    close();
+}
+
+MappedPpm::MappedPpm(MappedPpm&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedPpm& MappedPpm::operator=(MappedPpm&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+        m_RasterOffset = std::exchange(other.m_RasterOffset, 0);
+        m_Header = other.m_Header;
+#ifdef _WIN32
+        m_File = std::exchange(other.m_File, nullptr);
+        m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+bool MappedPpm::open(const std::string& input_file) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(input_file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Unable to open input PPM file " << input_file << "." << std::endl;
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        std::cerr << "Error: Unable to map empty PPM file " << input_file << "." << std::endl;
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data) {
+        std::cerr << "Error: Unable to map PPM file " << input_file << "." << std::endl;
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    m_File = file;
+    m_Mapping = mapping;
+    m_Size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(input_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Unable to open input PPM file " << input_file << "." << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "Error: Unable to map empty PPM file " << input_file << "." << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (data == MAP_FAILED) {
+        std::cerr << "Error: Unable to map PPM file " << input_file << "." << std::endl;
+        return false;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    m_Size = static_cast<std::size_t>(st.st_size);
+#endif
+    m_Data = static_cast<const unsigned char*>(data);
+
+    // Validate the header and make sure the whole raster is in the file
+    if (!parse_ppm_header(m_Data, m_Size, m_Header, m_RasterOffset)) {
+        close();
+        return false;
+    }
+    if (m_Header.type != "P6") {
+        std::cerr << "Error: Only binary (P6) PPM files can be mapped." << std::endl;
+        close();
+        return false;
+    }
+    const std::size_t raster_bytes = static_cast<std::size_t>(m_Header.width) * m_Header.height * sizeof(Pixel);
+    if (m_Size - m_RasterOffset < raster_bytes) {
+        std::cerr << "Error: PPM raster is truncated." << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedPpm::close() {
+    if (!m_Data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+    m_RasterOffset = 0;
+    m_Header = PpmHeader();
+}
+
+ImageView MappedPpm::view() const {
+    if (!m_Data) {
+        return ImageView();
+    }
+    return ImageView(m_Data + m_RasterOffset, m_Header.width, m_Header.height);
+}
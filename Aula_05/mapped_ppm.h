@@ -0,0 +1,52 @@
+#ifndef _MAPPED_PPM_H
+#define _MAPPED_PPM_H
+
+#include <cstddef>
+#include <string>
+
+#include "image.h"
+#include "ppm_io.h"
+
+// Class MappedPpm
+//
+// Memory-mapped P6 file. open() maps the file read-only and validates the
+// header; view() then exposes the raster in place, without reading it into
+// our own buffer. The mapping is shared, so concurrent processes working on
+// the same file share the page cache. Filters that need to mutate pixels
+// call materialize() to get a private, writable Image.
+
+class MappedPpm
+{
+public:
+    MappedPpm() = default;
+    ~MappedPpm();
+
+    MappedPpm(const MappedPpm&) = delete;
+    MappedPpm& operator=(const MappedPpm&) = delete;
+    MappedPpm(MappedPpm&& other) noexcept;
+    MappedPpm& operator=(MappedPpm&& other) noexcept;
+
+    bool open(const std::string& input_file);
+    void close();
+
+    bool is_open() const { return m_Data != nullptr; }
+    const PpmHeader& header() const { return m_Header; }
+
+    // Read-only pixels, straight from the mapping
+    ImageView view() const;
+    // Private writable copy of the pixels
+    Image materialize() const { return Image(view()); }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    std::size_t m_Size = 0;
+    std::size_t m_RasterOffset = 0;
+    PpmHeader m_Header;
+#ifdef _WIN32
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+#endif
+};
+
+
+#endif // !_MAPPED_PPM_H
@@ -0,0 +1,182 @@
+#include "median.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "parallel.h"
+
+namespace {
+
+// Column histograms of one strip are kept within this many bytes
+constexpr int kStripHistogramBytes = 512 * 1024;
+constexpr int kMinStripPixels = 32;
+
+// Marks fine bins that have to be summed again from the columns
+constexpr int kStale = -(1 << 30);
+
+// Two-level histogram of one channel: coarse[v >> 4] and fine[v >> 4][v & 15]
+struct ChannelHistogram {
+    uint16_t coarse[16];
+    uint16_t fine[16][16];
+};
+
+// Histograms of the 2r + 1 rows around the current row, for one column
+struct ColumnHistogram {
+    ChannelHistogram channel[3];
+};
+
+// Histogram of the window around the current pixel. The fine bins under
+// coarse bin k are valid for the pixel at column updated[k].
+struct WindowHistogram {
+    uint16_t coarse[16];
+    uint16_t fine[16][16];
+    int updated[16];
+};
+
+// bins += in - out, over 16 bins (counts wrap like the 16-bit lanes they vectorize to)
+inline void slide(uint16_t* bins, const uint16_t* in, const uint16_t* out) {
+    for (int k = 0; k < 16; ++k) {
+        bins[k] = static_cast<uint16_t>(bins[k] + in[k] - out[k]);
+    }
+}
+
+inline void accumulate(uint16_t* bins, const uint16_t* in) {
+    for (int k = 0; k < 16; ++k) {
+        bins[k] = static_cast<uint16_t>(bins[k] + in[k]);
+    }
+}
+
+// First of 16 bins at which the running count, starting from `below`, goes
+// past `rank`; `below` becomes the count before that bin
+inline int find_bin(const uint16_t* bins, int rank, int& below) {
+    int k = 0;
+    while (below + bins[k] <= rank) {
+        below += bins[k];
+        ++k;
+    }
+    return k;
+}
+
+class MedianStrip
+{
+public:
+    MedianStrip(const Image& source, int radius, std::vector<ColumnHistogram>& columns)
+        : m_Source(source), m_Radius(radius), m_Rank((2 * radius + 1) * (2 * radius + 1) / 2),
+          m_LastColumn(source.width() - 1), m_LastRow(source.height() - 1), m_Columns(columns) {}
+
+    // Median of the columns [x0, x1) of rows [y0, y1), written to `target`
+    void run(Image& target, int x0, int x1, int y0, int y1) {
+        m_First = std::max(x0 - m_Radius, 0);
+        const int end = std::min(x1 + m_Radius, m_LastColumn + 1);
+        m_Columns.assign(end - m_First, ColumnHistogram{});
+        for (int y = y0 - m_Radius; y <= y0 + m_Radius; ++y) {
+            update_columns(y, end, 1);
+        }
+
+        for (int y = y0; y < y1; ++y) {
+            if (y > y0) {
+                update_columns(y - m_Radius - 1, end, -1);
+                update_columns(y + m_Radius, end, 1);
+            }
+            // Window of x0: coarse bins summed, fine bins left for median()
+            for (int c = 0; c < 3; ++c) {
+                WindowHistogram& window = m_Window[c];
+                std::fill(std::begin(window.coarse), std::end(window.coarse), uint16_t(0));
+                std::fill(std::begin(window.updated), std::end(window.updated), kStale);
+                for (int x = x0 - m_Radius; x <= x0 + m_Radius; ++x) {
+                    accumulate(window.coarse, column(x).channel[c].coarse);
+                }
+            }
+            unsigned char* out = reinterpret_cast<unsigned char*>(target.row(y));
+            for (int x = x0; x < x1; ++x) {
+                for (int c = 0; c < 3; ++c) {
+                    if (x > x0) {
+                        slide(m_Window[c].coarse, column(x + m_Radius).channel[c].coarse,
+                              column(x - m_Radius - 1).channel[c].coarse);
+                    }
+                    out[3 * x + c] = median(m_Window[c], c, x);
+                }
+            }
+        }
+    }
+
+private:
+    const ColumnHistogram& column(int x) const {
+        return m_Columns[std::clamp(x, 0, m_LastColumn) - m_First];
+    }
+
+    // Add (delta 1) or remove (delta -1) source row y in every column histogram
+    void update_columns(int y, int end, int delta) {
+        const unsigned char* row = reinterpret_cast<const unsigned char*>(m_Source.row(std::clamp(y, 0, m_LastRow)));
+        for (int x = m_First; x < end; ++x) {
+            ColumnHistogram& histogram = m_Columns[x - m_First];
+            for (int c = 0; c < 3; ++c) {
+                const int value = row[3 * x + c];
+                ChannelHistogram& channel = histogram.channel[c];
+                channel.coarse[value >> 4] = static_cast<uint16_t>(channel.coarse[value >> 4] + delta);
+                channel.fine[value >> 4][value & 15] = static_cast<uint16_t>(channel.fine[value >> 4][value & 15] + delta);
+            }
+        }
+    }
+
+    unsigned char median(WindowHistogram& window, int c, int x) {
+        int below = 0;
+        const int k = find_bin(window.coarse, m_Rank, below);
+
+        // Bring the fine bins of coarse bin k to column x: slide them from
+        // where they were last used, or sum them again if that is cheaper
+        uint16_t* fine = window.fine[k];
+        const int behind = x - window.updated[k];
+        if (behind > m_Radius) {
+            std::fill(fine, fine + 16, uint16_t(0));
+            for (int i = x - m_Radius; i <= x + m_Radius; ++i) {
+                accumulate(fine, column(i).channel[c].fine[k]);
+            }
+        }
+        else {
+            for (int i = window.updated[k] + 1; i <= x; ++i) {
+                slide(fine, column(i + m_Radius).channel[c].fine[k], column(i - m_Radius - 1).channel[c].fine[k]);
+            }
+        }
+        window.updated[k] = x;
+
+        return static_cast<unsigned char>(16 * k + find_bin(fine, m_Rank, below));
+    }
+
+    const Image& m_Source;
+    int m_Radius;
+    int m_Rank; // the median is the value with m_Rank smaller ones in the window
+    int m_LastColumn;
+    int m_LastRow;
+    int m_First = 0; // column of m_Columns[0]
+    std::vector<ColumnHistogram>& m_Columns;
+    WindowHistogram m_Window[3];
+};
+
+} // namespace
+
+void median_filter(Image& image, int radius, int num_threads) {
+    radius = std::min(radius, kMaxMedianRadius);
+    if (radius <= 0 || image.empty()) {
+        return;
+    }
+    const Image source = image;
+    const int width = image.width();
+    const int columns = static_cast<int>(kStripHistogramBytes / sizeof(ColumnHistogram));
+    const int strip = std::max(kMinStripPixels, columns - 2 * radius);
+
+    parallel_for(0, image.height(), num_threads, [&](int start, int stop) {
+        std::vector<ColumnHistogram> histograms;
+        MedianStrip median(source, radius, histograms);
+        for (int x0 = 0; x0 < width; x0 += strip) {
+            median.run(image, x0, std::min(x0 + strip, width), start, stop);
+        }
+    });
+}
+
+Filter make_median_filter(int radius) {
+    Filter filter([radius](Image& image) { median_filter(image, radius); });
+    filter.name = "median";
+    return filter;
+}
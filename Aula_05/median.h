@@ -0,0 +1,31 @@
+#ifndef _MEDIAN_H
+#define _MEDIAN_H
+
+#include "filters.h"
+#include "image.h"
+
+// Largest radius median_filter accepts (larger ones are clamped): the counts
+// of a (2r + 1) x (2r + 1) window have to fit 16 bits
+constexpr int kMaxMedianRadius = 127;
+
+// Median filter: every channel becomes the median of that channel over the
+// (2r + 1) x (2r + 1) window around the pixel. Pixels outside the image take
+// the value of the nearest edge pixel.
+//
+// Constant time per pixel whatever the radius (Perreault & Hebert, 2007):
+// every column keeps a histogram of the 2r + 1 rows around the current row,
+// updated with one pixel in and one out per row, and the window histogram
+// slides along the row adding the column that comes in and subtracting the
+// one that goes out. Histograms have two levels, 16 coarse bins over the
+// high nibble and 16 fine bins under each; only the coarse bins are slid at
+// every pixel, and the fine bins of the coarse bin holding the median are
+// brought up to date when they are needed.
+//
+// The rows are split into one band per thread. Each band walks the image in
+// column strips narrow enough for their histograms to stay in the L2 cache.
+void median_filter(Image& image, int radius, int num_threads = 0);
+
+Filter make_median_filter(int radius);
+
+
+#endif // !_MEDIAN_H
@@ -0,0 +1,213 @@
+#include "morphology.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+namespace {
+
+// Lines run side by side: the pixels of a column strip in the vertical
+// pass, the rows of a block in the horizontal one. A position on the lines
+// is a fixed number of bytes, so the compiler can vectorize every loop over it.
+constexpr int kStripPixels = 64;
+constexpr int kRowBlock = 32;
+constexpr int kColumnLanes = 3 * kStripPixels;
+constexpr int kRowLanes = 3 * kRowBlock;
+
+struct Minimum {
+    // Value past the ends of a line, which never wins
+    static constexpr unsigned char kNeutral = 255;
+    static unsigned char apply(unsigned char a, unsigned char b) { return std::min(a, b); }
+};
+
+struct Maximum {
+    static constexpr unsigned char kNeutral = 0;
+    static unsigned char apply(unsigned char a, unsigned char b) { return std::max(a, b); }
+};
+
+template <typename Op, int Lanes>
+inline void combine(const unsigned char* a, const unsigned char* b, unsigned char* out) {
+    for (int j = 0; j < Lanes; ++j) {
+        out[j] = Op::apply(a[j], b[j]);
+    }
+}
+
+// Column strip [x0, x0 + pixels) of the image; positions are rows
+class ColumnLines
+{
+public:
+    ColumnLines(Image& image, int x0, int pixels) : m_Image(image), m_X0(x0), m_Bytes(3 * pixels) {}
+
+    void load(int y, unsigned char* lanes) const { std::memcpy(lanes, m_Image.row(y) + m_X0, m_Bytes); }
+    void store(int y, const unsigned char* lanes) { std::memcpy(m_Image.row(y) + m_X0, lanes, m_Bytes); }
+
+private:
+    Image& m_Image;
+    int m_X0;
+    int m_Bytes;
+};
+
+// Rows [y0, y0 + rows) of the image; positions are columns, and lanes
+// 3r .. 3r + 2 hold the pixel of row y0 + r
+class RowLines
+{
+public:
+    RowLines(Image& image, int y0, int rows) : m_Image(image), m_Y0(y0), m_Rows(rows) {}
+
+    void load(int x, unsigned char* lanes) const {
+        for (int r = 0; r < m_Rows; ++r) {
+            std::memcpy(lanes + 3 * r, m_Image.row(m_Y0 + r) + x, 3);
+        }
+    }
+    void store(int x, const unsigned char* lanes) {
+        for (int r = 0; r < m_Rows; ++r) {
+            std::memcpy(m_Image.row(m_Y0 + r) + x, lanes + 3 * r, 3);
+        }
+    }
+
+private:
+    Image& m_Image;
+    int m_Y0;
+    int m_Rows;
+};
+
+// Minimum / maximum over a window of `size` positions, in place along lines
+// of `count` positions: output i covers positions i - size / 2 onwards, or
+// i - (size - 1) / 2 onwards for the reflected window.
+//
+// With t = i + anchor the index into the line padded by neutral values,
+// blocks are t in [m size, (m + 1) size). `prefix` runs forwards and `suffix`
+// backwards within each block, and the window starting at padded index t is
+// op(suffix[t], prefix[t + size - 1]), a suffix of block m and a prefix of
+// block m + 1. Block m + 1 is read before the outputs of block m are
+// stored, and every position is read before it is overwritten.
+template <typename Op, int Lanes, typename Lines>
+void van_herk(Lines& lines, int count, int size, bool reflected, std::vector<unsigned char>& buffers) {
+    // Past 2 * count every window already covers the whole line
+    size = std::min(size, 2 * count);
+    const int anchor = reflected ? (size - 1) / 2 : size / 2;
+    const std::size_t block = static_cast<std::size_t>(size) * Lanes;
+    buffers.resize(3 * block);
+    unsigned char* previous = buffers.data();   // suffix of block m
+    unsigned char* prefix = previous + block;   // prefix of block m + 1
+    unsigned char* suffix = prefix + block;     // suffix of block m + 1
+
+    auto read_block = [&](int m) {
+        for (int j = 0; j < size; ++j) {
+            unsigned char* value = suffix + j * Lanes;
+            const int position = m * size + j - anchor;
+            if (position >= 0 && position < count) {
+                lines.load(position, value);
+            }
+            else {
+                std::fill(value, value + Lanes, Op::kNeutral);
+            }
+            if (j == 0) {
+                std::memcpy(prefix, value, Lanes);
+            }
+            else {
+                combine<Op, Lanes>(prefix + (j - 1) * Lanes, value, prefix + j * Lanes);
+            }
+        }
+        for (int j = size - 2; j >= 0; --j) {
+            combine<Op, Lanes>(suffix + j * Lanes, suffix + (j + 1) * Lanes, suffix + j * Lanes);
+        }
+    };
+
+    alignas(64) unsigned char out[Lanes];
+    read_block(0);
+    for (int m = 0; m * size < count; ++m) {
+        std::swap(previous, suffix);
+        read_block(m + 1);
+        // The window at the start of a block is the whole block
+        lines.store(m * size, previous);
+        for (int j = 1; j < size && m * size + j < count; ++j) {
+            combine<Op, Lanes>(previous + j * Lanes, prefix + (j - 1) * Lanes, out);
+            lines.store(m * size + j, out);
+        }
+    }
+}
+
+template <typename Op>
+void morphology(Image& image, int element_width, int element_height, bool reflected, int num_threads) {
+    if (image.empty()) {
+        return;
+    }
+    const int width = image.width();
+    const int height = image.height();
+
+    if (element_width > 1) {
+        const int blocks = (height + kRowBlock - 1) / kRowBlock;
+        parallel_for(0, blocks, num_threads, [&](int start, int stop) {
+            std::vector<unsigned char> buffers;
+            for (int b = start; b < stop; ++b) {
+                const int y0 = b * kRowBlock;
+                RowLines lines(image, y0, std::min(kRowBlock, height - y0));
+                van_herk<Op, kRowLanes>(lines, width, element_width, reflected, buffers);
+            }
+        });
+    }
+
+    if (element_height > 1) {
+        const int strips = (width + kStripPixels - 1) / kStripPixels;
+        parallel_for(0, strips, num_threads, [&](int start, int stop) {
+            std::vector<unsigned char> buffers;
+            for (int s = start; s < stop; ++s) {
+                const int x0 = s * kStripPixels;
+                ColumnLines lines(image, x0, std::min(kStripPixels, width - x0));
+                van_herk<Op, kColumnLanes>(lines, height, element_height, reflected, buffers);
+            }
+        });
+    }
+}
+
+Filter make_morphology_filter(const std::string& name, void (*function)(Image&, int, int, int),
+                              int element_width, int element_height) {
+    Filter filter([function, element_width, element_height](Image& image) {
+        function(image, element_width, element_height, 0);
+    });
+    filter.name = name;
+    return filter;
+}
+
+} // namespace
+
+void erode_filter(Image& image, int element_width, int element_height, int num_threads) {
+    morphology<Minimum>(image, element_width, element_height, false, num_threads);
+}
+
+void dilate_filter(Image& image, int element_width, int element_height, int num_threads) {
+    morphology<Maximum>(image, element_width, element_height, false, num_threads);
+}
+
+// The second pass uses the reflected element, so a pixel is only set back
+// from positions the first pass took it from (for odd sizes both are the same)
+void open_filter(Image& image, int element_width, int element_height, int num_threads) {
+    morphology<Minimum>(image, element_width, element_height, false, num_threads);
+    morphology<Maximum>(image, element_width, element_height, true, num_threads);
+}
+
+void close_filter(Image& image, int element_width, int element_height, int num_threads) {
+    morphology<Maximum>(image, element_width, element_height, false, num_threads);
+    morphology<Minimum>(image, element_width, element_height, true, num_threads);
+}
+
+Filter make_erode_filter(int element_width, int element_height) {
+    return make_morphology_filter("erode", erode_filter, element_width, element_height);
+}
+
+Filter make_dilate_filter(int element_width, int element_height) {
+    return make_morphology_filter("dilate", dilate_filter, element_width, element_height);
+}
+
+Filter make_open_filter(int element_width, int element_height) {
+    return make_morphology_filter("open", open_filter, element_width, element_height);
+}
+
+Filter make_close_filter(int element_width, int element_height) {
+    return make_morphology_filter("close", close_filter, element_width, element_height);
+}
@@ -0,0 +1,40 @@
+#ifndef _MORPHOLOGY_H
+#define _MORPHOLOGY_H
+
+#include "filters.h"
+#include "image.h"
+
+// Morphology with a rectangular structuring element of element_width x
+// element_height pixels, per channel: erode takes the minimum over the
+// element, dilate the maximum, open is an erode followed by a dilate
+// (removes specks smaller than the element) and close a dilate followed by
+// an erode (fills holes smaller than it). On the 0 / 255 output of
+// threshold_filter this is binary morphology. The element covers
+// x - w / 2 .. x - w / 2 + w - 1 (and the same vertically), so even sizes
+// reach one pixel further left / up; pixels outside the image are ignored.
+// The second pass of open / close uses the reflected element, which reaches
+// one pixel further right / down instead, so with any size open never
+// brightens, close never darkens, and neither moves edges.
+//
+// Cost does not depend on the element size (van Herk, 1992; Gil & Werman,
+// 1993): the rectangle is separable into a horizontal and a vertical line,
+// and along each line the positions are cut into blocks of the element
+// size. A running minimum / maximum forwards and one backwards within every
+// block give the result at any position from one value of each, so it is
+// three comparisons per pixel and axis in all.
+//
+// Lines are run many at a time, one vector lane per byte: the vertical pass
+// over column strips of 64 pixels and the horizontal pass over blocks of 32
+// rows, split between threads.
+void erode_filter(Image& image, int element_width, int element_height, int num_threads = 0);
+void dilate_filter(Image& image, int element_width, int element_height, int num_threads = 0);
+void open_filter(Image& image, int element_width, int element_height, int num_threads = 0);
+void close_filter(Image& image, int element_width, int element_height, int num_threads = 0);
+
+Filter make_erode_filter(int element_width, int element_height);
+Filter make_dilate_filter(int element_width, int element_height);
+Filter make_open_filter(int element_width, int element_height);
+Filter make_close_filter(int element_width, int element_height);
+
+
+#endif // !_MORPHOLOGY_H
@@ -0,0 +1,44 @@
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when the caller does not say (0 -> all cores)
+inline int default_thread_count(int num_threads = 0) {
+    if (num_threads > 0) {
+        return num_threads;
+    }
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores ? static_cast<int>(cores) : 1;
+}
+
+// Divide [begin, end) into num_threads regions and run fn(start, stop) on
+// each region in its own thread (the last region takes the remainder).
+// With one thread, or one item per thread or less, everything runs inline.
+template <typename Function>
+void parallel_for(int begin, int end, int num_threads, Function fn) {
+    int count = end - begin;
+    num_threads = std::min(default_thread_count(num_threads), std::max(count, 1));
+    if (num_threads <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    int per_region = count / num_threads;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        int start = begin + i * per_region;
+        int stop = (i == num_threads - 1) ? end : start + per_region;
+        threads.emplace_back(fn, start, stop);
+    }
+
+    // Wait for threads to finish
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+
+#endif // !_PARALLEL_H
@@ -0,0 +1,537 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+#include "parallel.h"
+
+namespace {
+
+// Pixels handed to each kernel of a fused run at a time: 3 KB, so the block
+// stays in L1 while every kernel of the run is applied to it
+constexpr int kFusedBlockPixels = 1024;
+
+// Collapse back-to-back lookup-table filters into one table
+std::vector<Filter> compose_luts(std::vector<Filter>::const_iterator first, std::vector<Filter>::const_iterator last) {
+    std::vector<Filter> stages;
+    for (auto it = first; it != last; ++it) {
+        if (it->lut && !stages.empty() && stages.back().lut) {
+            Filter& previous = stages.back();
+            previous = make_lut_filter(previous.name + "+" + it->name, compose(*previous.lut, *it->lut));
+        }
+        else {
+            stages.push_back(*it);
+        }
+    }
+    return stages;
+}
+
+Filter fuse_run(std::vector<Filter>::const_iterator first, std::vector<Filter>::const_iterator last) {
+    std::vector<Filter> stages = compose_luts(first, last);
+    if (stages.size() == 1) {
+        return stages.front();
+    }
+
+    std::string name;
+    std::vector<PointKernel> kernels;
+    for (const auto& stage : stages) {
+        name += (name.empty() ? "" : "+") + stage.name;
+        kernels.push_back(stage.point);
+    }
+    return make_point_filter(name, [kernels](Pixel* row, int width) {
+        for (int x = 0; x < width; x += kFusedBlockPixels) {
+            int count = std::min(kFusedBlockPixels, width - x);
+            for (const auto& kernel : kernels) {
+                kernel(row + x, count);
+            }
+        }
+    });
+}
+
+} // namespace
+
+std::vector<Filter> fuse_point_filters(const std::vector<Filter>& filters) {
+    std::vector<Filter> fused;
+    auto it = filters.begin();
+    while (it != filters.end()) {
+        if (it->kind != FilterKind::Point) {
+            fused.push_back(*it++);
+            continue;
+        }
+        auto run_end = it;
+        while (run_end != filters.end() && run_end->kind == FilterKind::Point) {
+            ++run_end;
+        }
+        fused.push_back(fuse_run(it, run_end));
+        it = run_end;
+    }
+    return fused;
+}
+
+void apply_pipeline(Image& image, const std::vector<Filter>& filters) {
+    for (const auto& filter : fuse_point_filters(filters)) {
+        filter.apply(image); // Apply each (fused) stage sequentially
+    }
+}
+
+namespace {
+
+// Pixels of one tile buffer including its halo. The three buffers of a
+// thread plus the rows read and written stay well inside L2.
+constexpr int kTilePixels = 32 * 1024;
+// Widest tile; narrower images use their full width
+constexpr int kMaxTileWidth = 512;
+constexpr int kMinTileRows = 8;
+
+struct Rect {
+    int x0, y0, x1, y1;
+};
+
+// Original rows [y0, y0 + rows.height()) of the image, kept before they are overwritten
+struct SavedRows {
+    int y0 = 0;
+    Image rows;
+};
+
+// Class TileRunner
+//
+// Runs a list of point and stencil stages in place over a horizontal band of
+// tiles. The input of a tile (the tile plus its halo) is copied into a
+// buffer; a point stage runs in place on the valid part of the buffer, a
+// stencil stage writes to a second buffer and its valid part shrinks by the
+// radius on every side that is not an image edge. Tiles away from the image
+// edges only ever run the kernels on interior pixels. At the image edges a
+// stencil follows its border mode exactly as apply_stencil_kernel does:
+// BorderMode::None leaves the rows and columns closer than r unchanged,
+// the other modes go through a padding StencilWindow.
+//
+// The halo must be read before the neighbouring tiles overwrite it: a tile's
+// result stays in its buffer until the next tile has read its input, and the
+// original rows a tile row needs from the row above (or from the bands of
+// other threads) are saved beforehand.
+
+class TileRunner
+{
+public:
+    TileRunner(const std::vector<Filter>& stages, int halo, Image& image, int tile_width, int tile_height)
+        : m_Stages(stages), m_Halo(halo), m_Image(image), m_TileWidth(tile_width), m_TileHeight(tile_height)
+    {
+        int width = std::min(tile_width + 2 * halo, image.width());
+        int height = std::min(tile_height + 2 * halo, image.height());
+        for (auto& buffer : m_Buffers) {
+            buffer = Image(width, height);
+        }
+    }
+
+    // Tiles rows [first_row, last_row); `above` and `below` are the original
+    // rows just outside the band
+    void run_band(int first_row, int last_row, const SavedRows& above, const SavedRows& below) {
+        const int height = m_Image.height();
+        m_BandY1 = std::min(last_row * m_TileHeight, height);
+        m_Below = &below;
+        m_Above = &above;
+        SavedRows next_above[2];
+        const int columns = (m_Image.width() + m_TileWidth - 1) / m_TileWidth;
+
+        for (int row = first_row; row < last_row; ++row) {
+            m_RowY0 = row * m_TileHeight;
+            const int y1 = std::min(m_RowY0 + m_TileHeight, height);
+
+            // The bottom of this tile row is the top halo of the next one
+            SavedRows& saved = next_above[row % 2];
+            if (m_Halo > 0 && row + 1 < last_row) {
+                saved.y0 = y1 - m_Halo;
+                save_rows(saved);
+            }
+
+            for (int column = 0; column < columns; ++column) {
+                const int x0 = column * m_TileWidth;
+                run_tile({ x0, m_RowY0, std::min(x0 + m_TileWidth, m_Image.width()), y1 });
+            }
+            m_Above = &saved;
+        }
+        store_pending();
+    }
+
+private:
+    // Original row y: rows above the current tile row and below the band
+    // come from the saved copies
+    const Pixel* original_row(int y) const {
+        if (y < m_RowY0) {
+            return m_Above->rows.row(y - m_Above->y0);
+        }
+        if (y >= m_BandY1) {
+            return m_Below->rows.row(y - m_Below->y0);
+        }
+        return m_Image.row(y);
+    }
+
+    void save_rows(SavedRows& saved) {
+        if (saved.rows.empty()) {
+            saved.rows = Image(m_Image.width(), m_Halo);
+        }
+        for (int k = 0; k < m_Halo; ++k) {
+            std::memcpy(saved.rows.row(k), m_Image.row(saved.y0 + k), m_Image.width() * sizeof(Pixel));
+        }
+    }
+
+    void store_pending() {
+        if (m_Pending < 0) {
+            return;
+        }
+        const Image& buffer = m_Buffers[m_Pending];
+        for (int y = m_PendingTile.y0; y < m_PendingTile.y1; ++y) {
+            std::memcpy(m_Image.row(y) + m_PendingTile.x0,
+                        buffer.row(y - m_PendingOrigin.y0) + (m_PendingTile.x0 - m_PendingOrigin.x0),
+                        (m_PendingTile.x1 - m_PendingTile.x0) * sizeof(Pixel));
+        }
+        m_Pending = -1;
+    }
+
+    void run_tile(const Rect& tile) {
+        const int width = m_Image.width();
+        const int height = m_Image.height();
+        Rect valid = { std::max(tile.x0 - m_Halo, 0), std::max(tile.y0 - m_Halo, 0),
+                       std::min(tile.x1 + m_Halo, width), std::min(tile.y1 + m_Halo, height) };
+        // Buffer pixel (0, 0) is image pixel (origin.x0, origin.y0)
+        const Rect origin = valid;
+
+        // The two buffers not holding the previous tile's result
+        int src = (m_Pending + 1) % 3;
+        int dst = (m_Pending + 2) % 3;
+        for (int y = valid.y0; y < valid.y1; ++y) {
+            std::memcpy(m_Buffers[src].row(y - origin.y0), original_row(y) + valid.x0, (valid.x1 - valid.x0) * sizeof(Pixel));
+        }
+        store_pending();
+
+        for (const auto& stage : m_Stages) {
+            const int offset = valid.x0 - origin.x0;
+            const int count = valid.x1 - valid.x0;
+            Image& in = m_Buffers[src];
+            if (stage.kind == FilterKind::Point) {
+                for (int y = valid.y0; y < valid.y1; ++y) {
+                    stage.point(in.row(y - origin.y0) + offset, count);
+                }
+                continue;
+            }
+
+            Image& out_buffer = m_Buffers[dst];
+            const int radius = stage.radius;
+            const Rect out = { valid.x0 == 0 ? 0 : valid.x0 + radius, valid.y0 == 0 ? 0 : valid.y0 + radius,
+                               valid.x1 == width ? width : valid.x1 - radius, valid.y1 == height ? height : valid.y1 - radius };
+            const bool at_edge = valid.x0 == 0 || valid.y0 == 0 || valid.x1 == width || valid.y1 == height;
+            if (at_edge && stage.border.mode != BorderMode::None) {
+                run_bordered(stage, in, out_buffer, valid, out, origin);
+                std::swap(src, dst);
+                valid = out;
+                continue;
+            }
+            m_Rows.resize(2 * radius + 1);
+            for (int y = out.y0; y < out.y1; ++y) {
+                Pixel* row = out_buffer.row(y - origin.y0) + offset;
+                if (y < radius || y >= height - radius) {
+                    std::memcpy(row, in.row(y - origin.y0) + offset, count * sizeof(Pixel));
+                    continue;
+                }
+                for (int k = 0; k <= 2 * radius; ++k) {
+                    m_Rows[k] = in.row(y - radius + k - origin.y0) + offset;
+                }
+                stage.stencil(m_Rows.data(), row, count);
+            }
+            std::swap(src, dst);
+            valid = out;
+        }
+
+        m_Pending = src;
+        m_PendingTile = tile;
+        m_PendingOrigin = origin;
+    }
+
+    // A stencil with a border mode over the valid part of a tile at an image
+    // edge. The window pads the sides of the valid part as if they were image
+    // edges; on the sides that are not, the padded pixels only reach the
+    // outputs that `out` leaves out.
+    void run_bordered(const Filter& stage, const Image& in, Image& out_buffer, const Rect& valid, const Rect& out, const Rect& origin) {
+        const int radius = stage.radius;
+        const int offset = valid.x0 - origin.x0;
+        const int count = valid.x1 - valid.x0;
+        const int rows = valid.y1 - valid.y0;
+        StencilWindow window(count, radius, stage.border, rows);
+        for (int k = 0; k < std::min(radius, rows); ++k) {
+            window.push(in.row(valid.y0 + k - origin.y0) + offset);
+        }
+        if (m_Padded.width() < count + 2 * radius) {
+            m_Padded = Image(count + 2 * radius, 1);
+        }
+        for (int y = valid.y0; y < valid.y1; ++y) {
+            if (y + radius < valid.y1) {
+                window.push(in.row(y + radius - origin.y0) + offset);
+            }
+            if (y < out.y0 || y >= out.y1) {
+                continue;
+            }
+            stage.stencil(window.rows_around(y - valid.y0), m_Padded.row(0), count + 2 * radius);
+            std::memcpy(out_buffer.row(y - origin.y0) + offset, m_Padded.row(0) + radius, count * sizeof(Pixel));
+        }
+    }
+
+    const std::vector<Filter>& m_Stages;
+    int m_Halo;
+    Image& m_Image;
+    int m_TileWidth;
+    int m_TileHeight;
+    Image m_Buffers[3];
+    std::vector<const Pixel*> m_Rows;
+    Image m_Padded;
+
+    int m_RowY0 = 0;
+    int m_BandY1 = 0;
+    const SavedRows* m_Above = nullptr;
+    const SavedRows* m_Below = nullptr;
+
+    int m_Pending = -1; // buffer holding a result not yet stored
+    Rect m_PendingTile = {};
+    Rect m_PendingOrigin = {};
+};
+
+// Run a list of point and stencil stages over the image tile by tile
+void run_tiled(Image& image, const std::vector<Filter>& stages, int num_threads) {
+    const int width = image.width();
+    const int height = image.height();
+    if (stages.empty() || width <= 0 || height <= 0) {
+        return;
+    }
+
+    int halo = 0;
+    for (const auto& stage : stages) {
+        halo += stage.radius;
+    }
+    // Tiles at least as large as the halo, so a halo only reaches the next tile
+    const int tile_width = std::min(width, std::max(kMaxTileWidth, halo));
+    const int tile_height = std::min(height, std::max({ kMinTileRows, halo, kTilePixels / (tile_width + 2 * halo) - 2 * halo }));
+    const int rows = (height + tile_height - 1) / tile_height;
+
+    // One band of tile rows per thread; the rows around each band are saved
+    // first, since the neighbouring bands overwrite them
+    const int bands = std::min(default_thread_count(num_threads), rows);
+    std::vector<SavedRows> above(bands);
+    std::vector<SavedRows> below(bands);
+    for (int b = 0; b < bands; ++b) {
+        const int y0 = (b * rows / bands) * tile_height;
+        const int y1 = std::min(((b + 1) * rows / bands) * tile_height, height);
+        above[b].y0 = std::max(y0 - halo, 0);
+        below[b].y0 = y1;
+        for (SavedRows* saved : { &above[b], &below[b] }) {
+            const int count = std::min(saved == &above[b] ? y0 - saved->y0 : height - y1, halo);
+            if (count > 0) {
+                saved->rows = Image(width, count);
+                for (int k = 0; k < count; ++k) {
+                    std::memcpy(saved->rows.row(k), image.row(saved->y0 + k), width * sizeof(Pixel));
+                }
+            }
+        }
+    }
+
+    parallel_for(0, bands, bands, [&](int first, int last) {
+        TileRunner runner(stages, halo, image, tile_width, tile_height);
+        for (int b = first; b < last; ++b) {
+            runner.run_band(b * rows / bands, (b + 1) * rows / bands, above[b], below[b]);
+        }
+    });
+}
+
+} // namespace
+
+void apply_pipeline_tiled(Image& image, const std::vector<Filter>& filters, int num_threads) {
+    std::vector<Filter> run;
+    for (const auto& filter : fuse_point_filters(filters)) {
+        // Wrap reads the far side of the image, so it cannot be tiled either
+        if (filter.kind != FilterKind::Image && filter.border.mode != BorderMode::Wrap) {
+            run.push_back(filter);
+            continue;
+        }
+        run_tiled(image, run, num_threads);
+        run.clear();
+        filter.apply(image);
+    }
+    run_tiled(image, run, num_threads);
+}
+
+namespace {
+
+typedef std::function<void(const Pixel* row)> RowSink;
+
+// Class ScanlinePipeline
+//
+// Push-based row pipeline: push() feeds input rows top to bottom, every
+// finished output row is handed to the sink in order.
+
+class ScanlinePipeline
+{
+public:
+    ScanlinePipeline(const std::vector<Filter>& filters, int width, int height, RowSink sink)
+        : m_Width(width), m_Height(height), m_Sink(std::move(sink))
+    {
+        for (const auto& filter : filters) {
+            Stage stage;
+            stage.filter = &filter;
+            if (filter.kind == FilterKind::Stencil) {
+                stage.window = std::make_unique<StencilWindow>(width, filter.radius, filter.border, height);
+                stage.out = Image(width + 2 * stage.window->padding(), 1);
+            }
+            m_Stages.push_back(std::move(stage));
+        }
+    }
+
+    void push(Pixel* row) { push_to(0, row); }
+    void finish() { finish_from(0); }
+
+    // Rows buffered by the stencil windows and their output rows
+    std::size_t buffer_bytes() const {
+        std::size_t bytes = 0;
+        for (const auto& stage : m_Stages) {
+            if (stage.window) {
+                bytes += (2 * stage.window->radius() + 2) * stage.out.width() * sizeof(Pixel);
+            }
+        }
+        return bytes;
+    }
+
+private:
+    struct Stage {
+        const Filter* filter = nullptr;
+        std::unique_ptr<StencilWindow> window;
+        Image out;
+        int emitted = 0;
+    };
+
+    void push_to(std::size_t index, Pixel* row) {
+        if (index == m_Stages.size()) {
+            m_Sink(row);
+            return;
+        }
+
+        Stage& stage = m_Stages[index];
+        if (stage.filter->kind == FilterKind::Point) {
+            stage.filter->point(row, m_Width);
+            push_to(index + 1, row);
+            return;
+        }
+
+        // Stencil: output row y is ready once row y + r has been pushed
+        stage.window->push(row);
+        int radius = stage.filter->radius;
+        while (stage.emitted < m_Height && stage.emitted + radius < stage.window->pushed()) {
+            emit(index, stage.emitted++);
+        }
+    }
+
+    void emit(std::size_t index, int y) {
+        Stage& stage = m_Stages[index];
+        int radius = stage.filter->radius;
+        Pixel* out = stage.out.row(0);
+        if (stage.window->padding() > 0) {
+            // Border mode: padded rows, the output starts at pixel r
+            stage.filter->stencil(stage.window->rows_around(y), out, stage.out.width());
+            push_to(index + 1, out + stage.window->padding());
+            return;
+        }
+        if (y < radius || y >= m_Height - radius) {
+            // Rows closer than r to the top or bottom are left unchanged
+            std::memcpy(out, stage.window->row(y), m_Width * sizeof(Pixel));
+        }
+        else {
+            stage.filter->stencil(stage.window->rows_around(y), out, m_Width);
+        }
+        push_to(index + 1, out);
+    }
+
+    void finish_from(std::size_t index) {
+        if (index == m_Stages.size()) {
+            return;
+        }
+        Stage& stage = m_Stages[index];
+        if (stage.window) {
+            while (stage.emitted < m_Height) {
+                emit(index, stage.emitted++);
+            }
+        }
+        finish_from(index + 1);
+    }
+
+    int m_Width;
+    int m_Height;
+    RowSink m_Sink;
+    std::vector<Stage> m_Stages;
+};
+
+} // namespace
+
+bool stream_ppm_pipeline(const std::string& input_file, const std::string& output_file,
+                         const std::vector<Filter>& filters, IoStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (const auto& filter : filters) {
+        if (filter.kind == FilterKind::Image || filter.border.mode == BorderMode::Wrap) {
+            std::cerr << "Error: Filter '" << filter.name << "' needs the whole image and cannot be streamed." << std::endl;
+            return false;
+        }
+    }
+
+    std::ifstream image_file(input_file, std::ios::binary);
+    if (!image_file.is_open()) {
+        std::cerr << "Error: Unable to open input PPM file " << input_file << "." << std::endl;
+        return false;
+    }
+    PpmHeader header;
+    if (!read_ppm_header(image_file, header)) {
+        return false;
+    }
+    if (header.type != "P6") {
+        std::cerr << "Error: Only binary (P6) PPM files can be streamed." << std::endl;
+        return false;
+    }
+
+    std::ofstream output_image(output_file, std::ios::binary);
+    if (!output_image.is_open()) {
+        std::cerr << "Error: Unable to open output PPM file " << output_file << "." << std::endl;
+        return false;
+    }
+    output_image << "P6\n" << header.width << " " << header.height << "\n" << header.max_value << "\n";
+
+    const std::size_t row_bytes = header.width * sizeof(Pixel);
+    const std::vector<Filter> stages = fuse_point_filters(filters);
+    ScanlinePipeline pipeline(stages, header.width, header.height, [&](const Pixel* row) {
+        output_image.write(reinterpret_cast<const char*>(row), row_bytes);
+    });
+
+    Image input_row(header.width, 1);
+    for (int i = 0; i < header.height; ++i) {
+        if (!image_file.read(reinterpret_cast<char*>(input_row.data()), row_bytes)) {
+            std::cerr << "Error: PPM raster is truncated." << std::endl;
+            return false;
+        }
+        pipeline.push(input_row.row(0));
+    }
+    pipeline.finish();
+
+    output_image.flush();
+    if (!output_image) {
+        std::cerr << "Error: Failed writing PPM file " << output_file << "." << std::endl;
+        return false;
+    }
+
+    std::cout << "Streaming buffers: " << (pipeline.buffer_bytes() + row_bytes) / 1024.0 << " KB for a "
+              << header.width << "x" << header.height << " image\n";
+    if (stats) {
+        stats->bytes = static_cast<std::size_t>(image_file.tellg()) + static_cast<std::size_t>(output_image.tellp());
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+    return true;
+}
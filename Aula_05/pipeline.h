@@ -0,0 +1,42 @@
+#ifndef _PIPELINE_H
+#define _PIPELINE_H
+
+#include <string>
+#include <vector>
+
+#include "filters.h"
+#include "image.h"
+#include "ppm_io.h"
+
+// Merge every run of consecutive point filters into a single point stage.
+// The fused kernel applies the whole run to one small block of pixels before
+// moving on, so the run costs one pass over memory instead of one per filter.
+// Neighbouring lookup-table filters inside a run are first composed into a
+// single table.
+// Stencil and image filters are passed through unchanged.
+std::vector<Filter> fuse_point_filters(const std::vector<Filter>& filters);
+
+// Apply multiple filters in a pipeline: one whole-image pass per stencil or
+// image filter and one per run of point filters
+void apply_pipeline(Image& image, const std::vector<Filter>& filters);
+
+// Cache-blocked mode, same result as apply_pipeline. Every run of point and
+// stencil filters is done tile by tile: a tile of about 96 KB is read together
+// with a halo as wide as the sum of the stencil radii, pushed through every
+// stage of the run (each stencil uses up its radius of the halo) and written
+// back before the next tile is started, so the intermediate results never
+// leave L2. Tiles are split between threads. Image filters, and stencils with
+// BorderMode::Wrap, run on the whole image between the tiled runs.
+void apply_pipeline_tiled(Image& image, const std::vector<Filter>& filters, int num_threads = 0);
+
+// Streaming mode: rows are read from the P6 input one at a time, pushed
+// through the point filters in place and through each stencil filter's
+// rolling window of 2r + 1 rows, and written out as soon as they are final.
+// Peak memory is O(width * sum of kernel heights), independent of the image
+// height. Every filter must be a point or stencil filter, and no stencil can
+// use BorderMode::Wrap.
+bool stream_ppm_pipeline(const std::string& input_file, const std::string& output_file,
+                         const std::vector<Filter>& filters, IoStats* stats = nullptr);
+
+
+#endif // !_PIPELINE_H
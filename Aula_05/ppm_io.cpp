@@ -0,0 +1,538 @@
+#include "ppm_io.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PPM_IO_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Byte sources the header parser can run on: a stream or a memory block
+struct StreamSource {
+    std::istream& in;
+
+    int peek() { return in.peek(); }
+    int get() { return in.get(); }
+};
+
+struct MemorySource {
+    const unsigned char* pos;
+    const unsigned char* end;
+
+    int peek() const { return pos < end ? *pos : -1; }
+    int get() { return pos < end ? *pos++ : -1; }
+};
+
+bool is_space(int c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool is_digit(int c) {
+    return c >= '0' && c <= '9';
+}
+
+// Skip whitespace and '#' comments between header fields
+template <typename Source>
+void skip_whitespace_and_comments(Source& src) {
+    int c;
+    while ((c = src.peek()) >= 0) {
+        if (c == '#') {
+            while ((c = src.get()) >= 0 && c != '\n') {
+            }
+        }
+        else if (is_space(c)) {
+            src.get();
+        }
+        else {
+            break;
+        }
+    }
+}
+
+// Read one unsigned decimal header field
+template <typename Source>
+bool read_header_value(Source& src, int& value) {
+    skip_whitespace_and_comments(src);
+    value = 0;
+    int digits = 0;
+    while (is_digit(src.peek())) {
+        value = value * 10 + (src.get() - '0');
+        if (++digits > 9) {
+            return false; // does not fit in an int
+        }
+    }
+    return digits > 0;
+}
+
+template <typename Source>
+bool parse_header(Source& src, PpmHeader& header) {
+    int magic0 = src.get();
+    int magic1 = src.get();
+    if (magic0 != 'P' || (magic1 != '3' && magic1 != '6')) {
+        std::cerr << "Error: Unsupported PPM format!" << std::endl;
+        return false;
+    }
+    header.type = { 'P', static_cast<char>(magic1) };
+
+    if (!read_header_value(src, header.width) || !read_header_value(src, header.height) ||
+        !read_header_value(src, header.max_value)) {
+        std::cerr << "Error: Malformed PPM header." << std::endl;
+        return false;
+    }
+    if (header.width <= 0 || header.height <= 0) {
+        std::cerr << "Error: Invalid PPM size " << header.width << "x" << header.height << "." << std::endl;
+        return false;
+    }
+    if (header.max_value <= 0 || header.max_value > 255) {
+        std::cerr << "Error: Only 8-bit PPM images are supported (max value " << header.max_value << ")." << std::endl;
+        return false;
+    }
+
+    // Exactly one whitespace character separates the header from the raster
+    if (!is_space(src.get())) {
+        std::cerr << "Error: Malformed PPM header." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// P3 body: whitespace and comments between samples
+const unsigned char* skip_p3_separators(const unsigned char* pos, const unsigned char* end) {
+    while (pos < end) {
+        if (is_space(*pos)) {
+            ++pos;
+        }
+        else if (*pos == '#') {
+            while (pos < end && *pos != '\n') {
+                ++pos;
+            }
+        }
+        else {
+            break;
+        }
+    }
+    return pos;
+}
+
+// Scalar path: one decimal sample, which must end at a separator or the end of the buffer
+bool parse_p3_sample(const unsigned char*& pos, const unsigned char* end, int& value) {
+    pos = skip_p3_separators(pos, end);
+    const unsigned char* start = pos;
+    value = 0;
+    while (pos < end && is_digit(*pos)) {
+        value = value * 10 + (*pos++ - '0');
+        if (pos - start > 9) {
+            return false;
+        }
+    }
+    return pos > start && (pos == end || is_space(*pos) || *pos == '#');
+}
+
+#ifdef PPM_IO_SSE2
+// Digit / whitespace masks of 16 bytes, plus the bytes minus '0'
+inline void classify_16(const unsigned char* p, unsigned char* values, unsigned& digits, unsigned& spaces) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i value = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+    _mm_store_si128(reinterpret_cast<__m128i*>(values), value);
+    // '0'..'9'  <=>  (byte - '0') <= 9 unsigned
+    __m128i as_digit = _mm_subs_epu8(value, _mm_set1_epi8(9));
+    digits = _mm_movemask_epi8(_mm_cmpeq_epi8(as_digit, zero));
+    // ' ' or '\t'..'\r'  <=>  (byte - 9) <= 4 unsigned
+    __m128i as_control = _mm_subs_epu8(_mm_sub_epi8(bytes, _mm_set1_epi8(9)), _mm_set1_epi8(4));
+    spaces = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '))) |
+             _mm_movemask_epi8(_mm_cmpeq_epi8(as_control, zero));
+}
+
+// Place values of the digits of a 1, 2 or 3 digit token
+const int digit_weights[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 10, 1, 0 }, { 100, 10, 1 } };
+
+// SSE2 path: classify 64 bytes at a time into digit / whitespace bit masks
+// and pull the 1-3 digit tokens out of the masks with bit scans instead of
+// testing every byte. Stops, leaving `pos` on a separator or token start,
+// as soon as a window needs the scalar path (comments, long tokens);
+// returns the number of samples written.
+std::size_t parse_p3_blocks_sse2(const unsigned char*& position, const unsigned char* end,
+                                 unsigned char* out, std::size_t count, int max_value, bool& out_of_range) {
+    // Locals, so the byte stores to `out` cannot alias them
+    const unsigned char* pos = position;
+    int largest = 0;
+    std::size_t n = 0;
+    while (n < count && end - pos >= 64) {
+        std::uint64_t digits = 0;
+        std::uint64_t spaces = 0;
+        // Digit values, padded so d[first + 2] is always readable
+        alignas(16) unsigned char values[80] = {};
+        for (int k = 0; k < 4; ++k) {
+            unsigned d, sp;
+            classify_16(pos + 16 * k, values + 16 * k, d, sp);
+            digits |= std::uint64_t(d) << (16 * k);
+            spaces |= std::uint64_t(sp) << (16 * k);
+        }
+
+        // Only tokens followed by whitespace before the first other byte
+        // ('#', garbage) or the window end are handled here
+        std::uint64_t other = ~(digits | spaces);
+        int limit = other ? std::countr_zero(other) : 64;
+
+        std::uint64_t starts = digits & ~(digits << 1);
+        std::uint64_t ends = digits & ~(digits >> 1);
+
+        int consumed = 0;
+        while (starts && n < count) {
+            int first = std::countr_zero(starts);
+            int last = std::countr_zero(ends);
+            int length = last - first + 1;
+            if (last + 1 >= limit || length > 3) {
+                break;
+            }
+            // Branch-free 1-3 digit value (the token lengths are unpredictable)
+            const unsigned char* d = values + first;
+            const int* weight = digit_weights[length];
+            int value = d[0] * weight[0] + d[1] * weight[1] + d[2] * weight[2];
+            largest = std::max(largest, value);
+            out[n++] = static_cast<unsigned char>(value);
+            consumed = last + 1;
+            starts &= starts - 1;
+            ends &= ends - 1;
+        }
+        if (consumed == 0) {
+            break;
+        }
+        pos += consumed;
+    }
+    out_of_range |= largest > max_value;
+    position = pos;
+    return n;
+}
+#endif
+
+// Count the samples (digit runs) in [pos, end); pos must not be in the middle of a token
+std::size_t count_p3_samples(const unsigned char* pos, const unsigned char* end) {
+    std::size_t samples = 0;
+    bool previous_digit = false;
+#ifdef PPM_IO_SSE2
+    unsigned carry = 0;
+    while (end - pos >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        __m128i as_digit = _mm_subs_epu8(_mm_sub_epi8(bytes, _mm_set1_epi8('0')), _mm_set1_epi8(9));
+        unsigned digits = _mm_movemask_epi8(_mm_cmpeq_epi8(as_digit, _mm_setzero_si128()));
+        // A sample starts on a digit that does not follow a digit
+        samples += std::popcount(digits & ~((digits << 1) | carry));
+        carry = (digits >> 15) & 1;
+        pos += 16;
+    }
+    previous_digit = carry != 0;
+#endif
+    for (; pos < end; ++pos) {
+        bool digit = is_digit(*pos);
+        samples += digit && !previous_digit;
+        previous_digit = digit;
+    }
+    return samples;
+}
+
+// "0" .. "255" as text, so writing a sample is a table lookup instead of
+// locale-aware stream formatting
+struct SampleText {
+    char digits[3];
+    unsigned char length;
+};
+
+const std::array<SampleText, 256> sample_text = [] {
+    std::array<SampleText, 256> table = {};
+    for (int value = 0; value < 256; ++value) {
+        SampleText& text = table[value];
+        if (value >= 100) {
+            text.digits[text.length++] = static_cast<char>('0' + value / 100);
+        }
+        if (value >= 10) {
+            text.digits[text.length++] = static_cast<char>('0' + value / 10 % 10);
+        }
+        text.digits[text.length++] = static_cast<char>('0' + value % 10);
+    }
+    return table;
+}();
+
+// Bytes of one P3 row: "r g b\n" per pixel
+std::size_t p3_row_size(const Pixel* row, int width) {
+    std::size_t size = 0;
+    for (int j = 0; j < width; ++j) {
+        size += sample_text[row[j].r].length + sample_text[row[j].g].length + sample_text[row[j].b].length + 3;
+    }
+    return size;
+}
+
+char* format_p3_row(const Pixel* row, int width, char* out) {
+    for (int j = 0; j < width; ++j) {
+        const unsigned char samples[3] = { row[j].r, row[j].g, row[j].b };
+        for (int c = 0; c < 3; ++c) {
+            const SampleText& text = sample_text[samples[c]];
+            // Only `length` bytes: a wider copy would run into the next
+            // thread's slice at the end of a block of rows
+            for (int k = 0; k < text.length; ++k) {
+                *out++ = text.digits[k];
+            }
+            *out++ = c < 2 ? ' ' : '\n';
+        }
+    }
+    return out;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+bool read_ppm_header(std::istream& in, PpmHeader& header) {
+    StreamSource src{ in };
+    return parse_header(src, header);
+}
+
+bool parse_ppm_header(const unsigned char* data, std::size_t size, PpmHeader& header, std::size_t& raster_offset) {
+    MemorySource src{ data, data + size };
+    if (!parse_header(src, header)) {
+        return false;
+    }
+    raster_offset = src.pos - data;
+    return true;
+}
+
+bool parse_p3_samples(const unsigned char* data, std::size_t size, unsigned char* out, std::size_t count,
+                      int max_value, std::size_t* consumed) {
+    const unsigned char* pos = data;
+    const unsigned char* end = data + size;
+    bool out_of_range = false;
+    std::size_t n = 0;
+    while (n < count) {
+#ifdef PPM_IO_SSE2
+        n += parse_p3_blocks_sse2(pos, end, out + n, count - n, max_value, out_of_range);
+        if (n == count) {
+            break;
+        }
+#endif
+        int value;
+        if (!parse_p3_sample(pos, end, value)) {
+            std::cerr << "Error: PPM raster is truncated or malformed." << std::endl;
+            return false;
+        }
+        out_of_range |= value > max_value;
+        out[n++] = static_cast<unsigned char>(value);
+    }
+    if (out_of_range) {
+        std::cerr << "Error: PPM sample larger than the max color value." << std::endl;
+        return false;
+    }
+    if (consumed) {
+        *consumed = pos - data;
+    }
+    return true;
+}
+
+bool parse_p3_samples_parallel(const unsigned char* data, std::size_t size, unsigned char* out, std::size_t count,
+                               int max_value, int num_threads) {
+    // Chunks are split on whitespace, which is only safe without comments
+    const std::size_t min_chunk_bytes = 256 * 1024;
+    int num_chunks = static_cast<int>(std::min<std::size_t>(default_thread_count(num_threads), size / min_chunk_bytes));
+    if (num_chunks <= 1 || std::memchr(data, '#', size)) {
+        return parse_p3_samples(data, size, out, count, max_value);
+    }
+
+    // Chunk boundaries, moved forward to the next whitespace byte
+    std::vector<std::size_t> bounds(num_chunks + 1, size);
+    bounds[0] = 0;
+    for (int k = 1; k < num_chunks; ++k) {
+        std::size_t b = std::max(bounds[k - 1], size / num_chunks * k);
+        while (b < size && !is_space(data[b])) {
+            ++b;
+        }
+        bounds[k] = b;
+    }
+
+    // Pass 1: count the samples of every chunk in parallel
+    std::vector<std::size_t> samples(num_chunks);
+    parallel_for(0, num_chunks, num_chunks, [&](int start, int stop) {
+        for (int k = start; k < stop; ++k) {
+            samples[k] = count_p3_samples(data + bounds[k], data + bounds[k + 1]);
+        }
+    });
+
+    // Prefix sum: where each chunk's samples go in the output
+    std::vector<std::size_t> offsets(num_chunks + 1, 0);
+    for (int k = 0; k < num_chunks; ++k) {
+        offsets[k + 1] = offsets[k] + samples[k];
+    }
+    if (offsets[num_chunks] < count) {
+        std::cerr << "Error: PPM raster is truncated or malformed." << std::endl;
+        return false;
+    }
+
+    // Pass 2: parse all chunks concurrently into the final buffer
+    std::vector<char> ok(num_chunks, 1);
+    parallel_for(0, num_chunks, num_chunks, [&](int start, int stop) {
+        for (int k = start; k < stop; ++k) {
+            if (offsets[k] >= count) {
+                continue; // trailing data after the last sample
+            }
+            std::size_t chunk_count = std::min(samples[k], count - offsets[k]);
+            ok[k] = parse_p3_samples(data + bounds[k], bounds[k + 1] - bounds[k], out + offsets[k], chunk_count, max_value);
+        }
+    });
+    return std::all_of(ok.begin(), ok.end(), [](char chunk_ok) { return chunk_ok != 0; });
+}
+
+bool read_ppm(const std::string& input_file, Image& image, PpmHeader* header, IoStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::ifstream image_file(input_file, std::ios::binary);
+    if (!image_file.is_open()) {
+        std::cerr << "Error: Unable to open input PPM file " << input_file << "." << std::endl;
+        return false;
+    }
+
+    PpmHeader file_header;
+    if (!read_ppm_header(image_file, file_header)) {
+        return false;
+    }
+
+    Image result(file_header.width, file_header.height);
+
+    if (file_header.type == "P6") {
+        // Whole raster in one read
+        image_file.read(reinterpret_cast<char*>(result.data()), result.size_bytes());
+        if (static_cast<std::size_t>(image_file.gcount()) != result.size_bytes()) {
+            std::cerr << "Error: PPM raster is truncated." << std::endl;
+            return false;
+        }
+    }
+    else {
+        // P3: read the whole ASCII body in one go, then parse it from memory
+        std::streamoff body_start = image_file.tellg();
+        image_file.seekg(0, std::ios::end);
+        std::size_t body_size = static_cast<std::size_t>(image_file.tellg() - body_start);
+        image_file.seekg(body_start);
+
+        std::unique_ptr<unsigned char[]> body(new unsigned char[body_size]);
+        image_file.read(reinterpret_cast<char*>(body.get()), body_size);
+        if (static_cast<std::size_t>(image_file.gcount()) != body_size ||
+            !parse_p3_samples_parallel(body.get(), body_size, result.data(), result.size_bytes(), file_header.max_value)) {
+            return false;
+        }
+    }
+
+    if (stats) {
+        stats->bytes = static_cast<std::size_t>(image_file.tellg());
+        stats->seconds = seconds_since(start_time);
+    }
+    if (header) {
+        *header = file_header;
+    }
+    image = std::move(result);
+    return true;
+}
+
+bool write_ppm(const std::string& output_file, const ImageView& image, int max_value, IoStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::ofstream output_image(output_file, std::ios::binary);
+    if (!output_image.is_open()) {
+        std::cerr << "Error: Unable to open output PPM file " << output_file << "." << std::endl;
+        return false;
+    }
+
+    output_image << "P6\n" << image.width() << " " << image.height() << "\n" << max_value << "\n";
+
+    const std::size_t row_bytes = image.width() * sizeof(Pixel);
+    if (image.is_packed()) {
+        // Whole raster in one write
+        output_image.write(reinterpret_cast<const char*>(image.data()), image.size_bytes());
+    }
+    else {
+        for (int i = 0; i < image.height(); ++i) {
+            output_image.write(reinterpret_cast<const char*>(image.row(i)), row_bytes);
+        }
+    }
+    output_image.flush();
+    if (!output_image) {
+        std::cerr << "Error: Failed writing PPM file " << output_file << "." << std::endl;
+        return false;
+    }
+
+    if (stats) {
+        stats->bytes = static_cast<std::size_t>(output_image.tellp());
+        stats->seconds = seconds_since(start_time);
+    }
+    return true;
+}
+
+void print_io_stats(const std::string& label, const IoStats& stats) {
+    std::cout << label << ": " << stats.bytes / (1024.0 * 1024.0) << " MB in " << stats.seconds
+              << " seconds (" << stats.mb_per_second() << " MB/s)\n";
+}
+
+bool write_ppm_ascii(const std::string& output_file, const ImageView& image, int max_value, IoStats* stats,
+                     int num_threads) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::ofstream output_image(output_file, std::ios::binary);
+    if (!output_image.is_open()) {
+        std::cerr << "Error: Unable to open output PPM file " << output_file << "." << std::endl;
+        return false;
+    }
+
+    const std::string header = "P3\n" + std::to_string(image.width()) + " " + std::to_string(image.height()) +
+                               "\n" + std::to_string(max_value) + "\n";
+    const int height = image.height();
+
+    // Pass 1: size of every formatted row, then each row's offset in the output
+    std::vector<std::size_t> offsets(height + 1, 0);
+    parallel_for(0, height, num_threads, [&](int start, int stop) {
+        for (int i = start; i < stop; ++i) {
+            offsets[i + 1] = p3_row_size(image.row(i), image.width());
+        }
+    });
+    offsets[0] = header.size();
+    for (int i = 0; i < height; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    // Pass 2: every thread formats its block of rows straight into its slice
+    // of the output buffer
+    std::unique_ptr<char[]> text(new char[offsets[height]]);
+    std::memcpy(text.get(), header.data(), header.size());
+    parallel_for(0, height, num_threads, [&](int start, int stop) {
+        char* out = text.get() + offsets[start];
+        for (int i = start; i < stop; ++i) {
+            out = format_p3_row(image.row(i), image.width(), out);
+        }
+    });
+
+    // One write for the whole file
+    output_image.write(text.get(), offsets[height]);
+    output_image.flush();
+    if (!output_image) {
+        std::cerr << "Error: Failed writing PPM file " << output_file << "." << std::endl;
+        return false;
+    }
+
+    if (stats) {
+        stats->bytes = offsets[height];
+        stats->seconds = seconds_since(start_time);
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef _PPM_IO_H
+#define _PPM_IO_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+#include "image.h"
+
+// PPM header: "P6" (binary) or "P3" (ASCII), width, height and max color value
+struct PpmHeader {
+    std::string type;
+    int width = 0;
+    int height = 0;
+    int max_value = 255;
+};
+
+// Bytes moved and time spent by one read/write call
+struct IoStats {
+    std::size_t bytes = 0;
+    double seconds = 0.0;
+
+    double mb_per_second() const { return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+// Parse a PPM header. Comments ('#' up to the end of the line) and any amount
+// of whitespace are allowed between the fields; after max_value exactly one
+// whitespace character is consumed, so the stream is left on the first raster byte.
+bool read_ppm_header(std::istream& in, PpmHeader& header);
+
+// Same as read_ppm_header for a header held in memory (e.g. a mapped file).
+// On success `raster_offset` is the position of the first raster byte.
+bool parse_ppm_header(const unsigned char* data, std::size_t size, PpmHeader& header, std::size_t& raster_offset);
+
+// Parse `count` ASCII (P3) samples from [data, data + size) into `out`,
+// skipping whitespace and comments. Fails on malformed or truncated input and
+// on samples above max_value. `consumed` receives the bytes parsed.
+bool parse_p3_samples(const unsigned char* data, std::size_t size, unsigned char* out, std::size_t count,
+                      int max_value, std::size_t* consumed = nullptr);
+
+// Same as parse_p3_samples, on several threads (0 -> all cores): the buffer
+// is split into chunks at whitespace, the samples of every chunk are counted
+// in parallel, a prefix sum gives each chunk its output offset, and then all
+// chunks are parsed concurrently. Bodies with comments, or too small to be
+// worth splitting, are parsed on the calling thread.
+bool parse_p3_samples_parallel(const unsigned char* data, std::size_t size, unsigned char* out, std::size_t count,
+                               int max_value, int num_threads = 0);
+
+// Read a PPM file into `image`. The P6 raster is moved with a single read
+// straight into the contiguous Image buffer; a P3 body is read in one go
+// and parsed from memory with parse_p3_samples_parallel.
+bool read_ppm(const std::string& input_file, Image& image, PpmHeader* header = nullptr, IoStats* stats = nullptr);
+
+// Write `image` (an Image or any view) as P6: header + a single write of the whole raster
+bool write_ppm(const std::string& output_file, const ImageView& image, int max_value = 255, IoStats* stats = nullptr);
+
+// Write `image` as ASCII P3, one "r g b" pixel per line. Samples are
+// formatted from a 0-255 digit table, blocks of rows are formatted on several
+// threads (0 -> all cores) directly into one buffer, and the file is written
+// with a single write.
+bool write_ppm_ascii(const std::string& output_file, const ImageView& image, int max_value = 255,
+                     IoStats* stats = nullptr, int num_threads = 0);
+
+// Print "<label>: <MB> MB in <s> seconds (<MB/s> MB/s)"
+void print_io_stats(const std::string& label, const IoStats& stats);
+
+
+#endif // !_PPM_IO_H
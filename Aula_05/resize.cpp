@@ -0,0 +1,271 @@
+#include "resize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "filters_simd.h"
+#include "parallel.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Rows gathered per block in the horizontal pass; their pixels at one
+// column are kLanes consecutive bytes. Results are written back to the rows
+// kChunkColumns at a time, one row after the other (writing every column to
+// its 32 rows straight away touches 32 lines a row apart, which often share
+// cache sets).
+constexpr int kRowBlock = 32;
+constexpr int kLanes = 3 * kRowBlock;
+constexpr int kChunkColumns = 128;
+
+double kernel_support(ResizeKernel kernel) {
+    switch (kernel) {
+    case ResizeKernel::Box:
+        return 0.5;
+    case ResizeKernel::Bilinear:
+        return 1.0;
+    case ResizeKernel::Bicubic:
+        return 2.0;
+    case ResizeKernel::Lanczos3:
+    default:
+        return 3.0;
+    }
+}
+
+double sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= kPi;
+    return std::sin(x) / x;
+}
+
+double kernel_value(ResizeKernel kernel, double x) {
+    switch (kernel) {
+    case ResizeKernel::Box:
+        return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+    case ResizeKernel::Bilinear:
+        return std::max(0.0, 1.0 - std::abs(x));
+    case ResizeKernel::Bicubic: {
+        constexpr double a = -0.5;
+        x = std::abs(x);
+        if (x < 1.0) {
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        }
+        if (x < 2.0) {
+            return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+        }
+        return 0.0;
+    }
+    case ResizeKernel::Lanczos3:
+    default:
+        return (std::abs(x) < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+    }
+}
+
+// Weights of one axis: target pixel i is the sum of weights[i * taps + k]
+// times source pixel first[i] + k, for k < taps (clamped to the last pixel,
+// where the weights are 0)
+struct ResampleTable {
+    int taps = 0; // even, as the kernels take the rows in pairs
+    std::vector<int> first;
+    std::vector<short> weights;
+};
+
+ResampleTable resample_table(ResizeKernel kernel, int source, int target) {
+    const double scale = static_cast<double>(source) / target;
+    // Shrinking stretches the kernel over the source pixels of one target pixel
+    const double stretch = std::max(scale, 1.0);
+    const double support = kernel_support(kernel) * stretch;
+
+    ResampleTable table;
+    table.taps = 2 * static_cast<int>(std::ceil(support)) + 1;
+    table.taps += table.taps % 2;
+    table.first.resize(target);
+    table.weights.assign(static_cast<std::size_t>(target) * table.taps, 0);
+
+    std::vector<double> values(table.taps);
+    for (int i = 0; i < target; ++i) {
+        const double centre = (i + 0.5) * scale;
+        const int begin = std::max(0, static_cast<int>(std::floor(centre - support + 0.5)));
+        const int end = std::min(source, static_cast<int>(std::floor(centre + support + 0.5)));
+        const int count = std::max(end - begin, 0);
+
+        double total = 0.0;
+        for (int k = 0; k < count; ++k) {
+            values[k] = kernel_value(kernel, (begin + k + 0.5 - centre) / stretch);
+            total += values[k];
+        }
+
+        // Move the window left so it stays inside the image where it can;
+        // the weights keep their source pixels
+        const int first = std::max(0, std::min(begin, source - table.taps));
+        table.first[i] = first;
+        short* weights = &table.weights[static_cast<std::size_t>(i) * table.taps + (begin - first)];
+        if (count == 0 || total == 0.0) {
+            // Cannot happen with these kernels; fall back to the nearest pixel
+            const int nearest = std::clamp(static_cast<int>(centre), 0, source - 1);
+            table.first[i] = std::max(0, std::min(nearest, source - table.taps));
+            table.weights[static_cast<std::size_t>(i) * table.taps + (nearest - table.first[i])] = 1 << kResampleBits;
+            continue;
+        }
+
+        // Round to Q14 and give the rounding error to the largest weight, so
+        // a flat area stays exactly flat
+        int sum = 0;
+        int largest = 0;
+        for (int k = 0; k < count; ++k) {
+            weights[k] = static_cast<short>(std::lround(values[k] / total * (1 << kResampleBits)));
+            sum += weights[k];
+            if (weights[k] > weights[largest]) {
+                largest = k;
+            }
+        }
+        weights[largest] = static_cast<short>(weights[largest] + (1 << kResampleBits) - sum);
+    }
+    return table;
+}
+
+// Rows of target from the rows of source (same width)
+void vertical_pass(const ImageView& source, Image& target, const ResampleTable& table, int num_threads) {
+    const RowKernels& kernels = active_row_kernels();
+    const int last = source.height() - 1;
+    const int bytes = 3 * source.width();
+    parallel_for(0, target.height(), num_threads, [&](int start, int stop) {
+        std::vector<const unsigned char*> rows(table.taps);
+        for (int y = start; y < stop; ++y) {
+            for (int k = 0; k < table.taps; ++k) {
+                rows[k] = reinterpret_cast<const unsigned char*>(source.row(std::min(table.first[y] + k, last)));
+            }
+            kernels.resample(rows.data(), &table.weights[static_cast<std::size_t>(y) * table.taps], table.taps,
+                             reinterpret_cast<unsigned char*>(target.row(y)), bytes);
+        }
+    });
+}
+
+// Columns of target from the columns of source (same height). A block of
+// rows is gathered column by column, so the same kernel as the vertical pass
+// runs across the rows, and the results are scattered back.
+void horizontal_pass(const ImageView& source, Image& target, const ResampleTable& table, int num_threads) {
+    const RowKernels& kernels = active_row_kernels();
+    const int width = source.width();
+    const int height = source.height();
+    const int blocks = (height + kRowBlock - 1) / kRowBlock;
+    parallel_for(0, blocks, num_threads, [&](int start, int stop) {
+        // Zeroed, so the lanes of a short last block are defined
+        std::vector<unsigned char> columns(static_cast<std::size_t>(width) * kLanes);
+        std::vector<unsigned char> results(static_cast<std::size_t>(kChunkColumns) * kLanes);
+        std::vector<const unsigned char*> rows(table.taps);
+        for (int b = start; b < stop; ++b) {
+            const int y0 = b * kRowBlock;
+            const int count = std::min(kRowBlock, height - y0);
+            for (int r = 0; r < count; ++r) {
+                const Pixel* row = source.row(y0 + r);
+                for (int x = 0; x < width; ++x) {
+                    std::memcpy(&columns[static_cast<std::size_t>(x) * kLanes + 3 * r], row + x, 3);
+                }
+            }
+            for (int x0 = 0; x0 < target.width(); x0 += kChunkColumns) {
+                const int x1 = std::min(x0 + kChunkColumns, target.width());
+                for (int x = x0; x < x1; ++x) {
+                    for (int k = 0; k < table.taps; ++k) {
+                        rows[k] = &columns[static_cast<std::size_t>(std::min(table.first[x] + k, width - 1)) * kLanes];
+                    }
+                    kernels.resample(rows.data(), &table.weights[static_cast<std::size_t>(x) * table.taps], table.taps,
+                                     &results[static_cast<std::size_t>(x - x0) * kLanes], kLanes);
+                }
+                for (int r = 0; r < count; ++r) {
+                    Pixel* row = target.row(y0 + r);
+                    for (int x = x0; x < x1; ++x) {
+                        std::memcpy(row + x, &results[static_cast<std::size_t>(x - x0) * kLanes + 3 * r], 3);
+                    }
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+void resample_row_scalar(const unsigned char* const* rows, const short* weights, int taps, unsigned char* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        int sum = 1 << (kResampleBits - 1);
+        for (int k = 0; k < taps; ++k) {
+            sum += weights[k] * rows[k][i];
+        }
+        out[i] = static_cast<unsigned char>(std::clamp(sum >> kResampleBits, 0, 255));
+    }
+}
+
+const char* resize_kernel_name(ResizeKernel kernel) {
+    switch (kernel) {
+    case ResizeKernel::Box:
+        return "box";
+    case ResizeKernel::Bilinear:
+        return "bilinear";
+    case ResizeKernel::Bicubic:
+        return "bicubic";
+    case ResizeKernel::Lanczos3:
+    default:
+        return "lanczos3";
+    }
+}
+
+Image resize_image(const ImageView& source, int width, int height, ResizeKernel kernel, int num_threads) {
+    if (source.empty() || width <= 0 || height <= 0) {
+        return Image();
+    }
+    const bool resize_x = (width != source.width());
+    const bool resize_y = (height != source.height());
+    if (!resize_x && !resize_y) {
+        return Image(source);
+    }
+
+    Image target(width, height);
+    if (!resize_x) {
+        vertical_pass(source, target, resample_table(kernel, source.height(), height), num_threads);
+        return target;
+    }
+    const ResampleTable columns = resample_table(kernel, source.width(), width);
+    if (!resize_y) {
+        horizontal_pass(source, target, columns, num_threads);
+        return target;
+    }
+    const ResampleTable rows = resample_table(kernel, source.height(), height);
+
+    // Multiplies of each order: the first pass runs on the source size along
+    // the other axis, the second on the target size
+    const double vertical_first = static_cast<double>(height) * source.width() * rows.taps +
+                                  static_cast<double>(height) * width * columns.taps;
+    const double horizontal_first = static_cast<double>(source.height()) * width * columns.taps +
+                                    static_cast<double>(height) * width * rows.taps;
+    if (vertical_first <= horizontal_first) {
+        Image between(source.width(), height);
+        vertical_pass(source, between, rows, num_threads);
+        horizontal_pass(between, target, columns, num_threads);
+    }
+    else {
+        Image between(width, source.height());
+        horizontal_pass(source, between, columns, num_threads);
+        vertical_pass(between, target, rows, num_threads);
+    }
+    return target;
+}
+
+void resize_filter(Image& image, int width, int height, ResizeKernel kernel, int num_threads) {
+    Image resized = resize_image(image, width, height, kernel, num_threads);
+    if (!resized.empty()) {
+        image = std::move(resized);
+    }
+}
+
+Filter make_resize_filter(int width, int height, ResizeKernel kernel) {
+    Filter filter([width, height, kernel](Image& image) { resize_filter(image, width, height, kernel); });
+    filter.name = std::string("resize-") + resize_kernel_name(kernel);
+    return filter;
+}
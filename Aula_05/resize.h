@@ -0,0 +1,42 @@
+#ifndef _RESIZE_H
+#define _RESIZE_H
+
+#include "filters.h"
+#include "image.h"
+
+// Resampling kernels, from fastest / blockiest to sharpest
+enum class ResizeKernel {
+    Box,      // mean of the source pixels under the target pixel (nearest when enlarging)
+    Bilinear, // triangle, support 1
+    Bicubic,  // Keys cubic with a = -0.5, support 2
+    Lanczos3  // sinc(x) sinc(x / 3), support 3
+};
+
+const char* resize_kernel_name(ResizeKernel kernel);
+
+// Resize to width x height, shrinking or enlarging each axis independently.
+// When shrinking, the kernel is stretched by the scale so every source pixel
+// contributes (no aliasing); near the edges it is cut at the image and its
+// weights renormalized.
+//
+// The resize is separable: one weight table per axis, computed once in Q14
+// (each row of weights adds up to exactly 1 << 14), then a vertical and a
+// horizontal pass in 32-bit fixed point, in the order that needs fewer
+// multiplies, with an 8-bit image between them. Both passes run the
+// vectorized resample row kernel (filters_simd.h) across pixels: the
+// vertical pass along the rows directly, the horizontal pass on blocks of
+// 32 rows gathered so that a source column is one contiguous run of bytes.
+// Each pass splits its output rows between threads.
+//
+// The source is any ImageView, so an stbi_load buffer is read where it is,
+// without copying it into an Image first:
+//   resize_image(ImageView(data, width, height), 160, 120)
+// An empty source or a size below 1 gives an empty Image.
+Image resize_image(const ImageView& source, int width, int height, ResizeKernel kernel = ResizeKernel::Bicubic,
+                   int num_threads = 0);
+void resize_filter(Image& image, int width, int height, ResizeKernel kernel = ResizeKernel::Bicubic, int num_threads = 0);
+
+Filter make_resize_filter(int width, int height, ResizeKernel kernel = ResizeKernel::Bicubic);
+
+
+#endif // !_RESIZE_H